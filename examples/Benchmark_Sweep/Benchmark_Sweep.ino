@@ -0,0 +1,230 @@
+/*
+  Benchmark sweep example
+
+  Measures the driver on real hardware the way the host runner
+  (extras/host, bench_ad7794 --sweep) does against the simulated chip:
+  every update rate, single vs continuous mode, chop on and off, and 1-6
+  enabled channels. Prints one CSV line per case with the achieved samples
+  per second against the expected rate, bus occupancy, bytes per sample and
+  percentiles of the time from asking for a sample to having it. The
+  columns match the host runner's CSV, less the ready_* columns, so the two
+  can be compared directly. Bus occupancy here is the time between
+  beginTransaction() and endTransaction(), not just the clocking.
+
+  The slowest rates take most of the time (a full sweep with 16 samples per
+  case runs for about 10 minutes). Raise SWEEP_MIN_RATE to skip them.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2021  Jaimy Juliano
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <SPI.h>
+#include "NHB_AD7794.h"
+
+//Pins for Feather M0 Basic Proto
+#define AD7794_CS  10
+#define EX_EN_PIN  9
+
+#define SWEEP_SAMPLES   16
+#define SWEEP_MIN_RATE  4       //Hz
+
+//Counts bytes and the time the bus is held
+class TimingTransport : public AD7794_SPITransport
+{
+  public:
+    TimingTransport() : AD7794_SPITransport(SPI) {}
+
+    void beginTransaction(const SPISettings &settings)
+    {
+      started = micros();
+      AD7794_SPITransport::beginTransaction(settings);
+    }
+    void endTransaction()
+    {
+      AD7794_SPITransport::endTransaction();
+      busyUs += micros() - started;
+    }
+    uint8_t transfer(uint8_t data)
+    {
+      bytes++;
+      return AD7794_SPITransport::transfer(data);
+    }
+    void transfer(uint8_t *buf, uint16_t len)
+    {
+      bytes += len;
+      AD7794_SPITransport::transfer(buf, len);
+    }
+
+    uint32_t busyUs = 0;
+    uint32_t bytes = 0;
+
+  private:
+    uint32_t started = 0;
+};
+
+TimingTransport port;
+AD7794 adc(AD7794_CS, 4000000, 2.50, port);
+
+//One per FS code setUpdateRate() can select
+const float rates[] = { 470, 242, 123, 62, 50, 39, 33.2, 19.6, 16.7, 12.5, 10, 8.33, 6.25, 4.17 };
+
+uint32_t interval[SWEEP_SAMPLES];
+
+void waitUs(uint32_t us)
+{
+  if(us > 10000){
+    delay(us / 1000);
+  }
+  else{
+    delayMicroseconds(us);
+  }
+}
+
+void sortIntervals()
+{
+  for(uint8_t i = 1; i < SWEEP_SAMPLES; i++){
+    uint32_t v = interval[i];
+    uint8_t j = i;
+    for(; j > 0 && interval[j - 1] > v; j--){
+      interval[j] = interval[j - 1];
+    }
+    interval[j] = v;
+  }
+}
+
+void runCase(float rate, bool continuous, bool chop, uint8_t n, float settleRate)
+{
+  adc.setUpdateRate(rate);
+  adc.setChopEnabled(chop);
+  for(uint8_t ch = 0; ch < 6; ch++){
+    adc.setEnabled(ch, ch < n);
+  }
+  adc.setMode(continuous ? AD7794_OpMode_Continuous : AD7794_OpMode_SingleConv);
+
+  float nominal = adc.getUpdateRate(0);
+  float expected = (continuous && n == 1) ? nominal : settleRate;
+  uint32_t gap = 1e6 / nominal / 32;
+  if(gap < 20){
+    gap = 20;
+  }
+
+  AD7794_Sample s;
+  if(continuous){
+    adc.startScan();
+  }
+  for(uint8_t i = 0; i <= SWEEP_SAMPLES; i++){
+    if(i == 1){
+      //The first result was the warm-up
+      port.busyUs = 0;
+      port.bytes = 0;
+    }
+    uint32_t t0 = micros();
+    if(continuous){
+      while(!adc.pollScan(s)){
+        uint32_t wait = adc.getScanWait();
+        waitUs(wait ? wait : gap);
+      }
+    }
+    else{
+      adc.getReadingRaw(i % n);
+    }
+    if(i > 0){
+      interval[i - 1] = micros() - t0;
+    }
+  }
+  if(continuous){
+    adc.stopScan();
+  }
+
+  uint32_t elapsed = 0;
+  for(uint8_t i = 0; i < SWEEP_SAMPLES; i++){
+    elapsed += interval[i];
+  }
+  sortIntervals();
+
+  float sps = SWEEP_SAMPLES * 1e6 / elapsed;
+  Serial.print(AD7794_rateCode(rate));     Serial.print(',');
+  Serial.print(nominal, 2);                Serial.print(',');
+  Serial.print(continuous ? F("continuous") : F("single")); Serial.print(',');
+  Serial.print(chop);                      Serial.print(',');
+  Serial.print(n);                         Serial.print(',');
+  Serial.print(SWEEP_SAMPLES);             Serial.print(',');
+  Serial.print(sps, 2);                    Serial.print(',');
+  Serial.print(expected, 2);               Serial.print(',');
+  Serial.print(sps / expected, 3);         Serial.print(',');
+  Serial.print(100.0 * port.busyUs / elapsed, 2); Serial.print(',');
+  Serial.print((float)port.bytes / SWEEP_SAMPLES, 2); Serial.print(',');
+  Serial.print(interval[SWEEP_SAMPLES / 2]);            Serial.print(',');
+  Serial.print(interval[(SWEEP_SAMPLES * 9) / 10]);     Serial.print(',');
+  Serial.print(interval[(SWEEP_SAMPLES * 99) / 100]);   Serial.print(',');
+  Serial.println(interval[SWEEP_SAMPLES - 1]);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  while(!Serial);
+
+  pinMode(EX_EN_PIN, OUTPUT);
+  digitalWrite(EX_EN_PIN, LOW);
+
+  adc.begin();
+  for(uint8_t ch = 0; ch < 6; ch++){
+    adc.setBipolar(ch, true);
+    adc.setGain(ch, 128);
+  }
+
+  Serial.println(F("rate_code,nominal_hz,mode,chop,channels,samples,sps,expected_sps,efficiency,"
+                   "bus_pct,bytes_per_sample,interval_p50_us,interval_p90_us,interval_p99_us,interval_max_us"));
+
+  for(uint8_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++){
+    if(rates[r] < SWEEP_MIN_RATE){
+      continue;
+    }
+    for(uint8_t cont = 0; cont < 2; cont++){
+      for(uint8_t c = 0; c < 2; c++){
+        bool chop = (c == 0);
+
+        //Every sample after a channel or mode write waits one settling time.
+        //A scan over two channels has exactly that per sample.
+        adc.setUpdateRate(rates[r]);
+        adc.setChopEnabled(chop);
+        for(uint8_t ch = 0; ch < 6; ch++){
+          adc.setEnabled(ch, ch < 2);
+        }
+        float settleRate = adc.getScanRate() * 2;
+
+        for(uint8_t n = 1; n <= 6; n++){
+          runCase(rates[r], cont, chop, n, settleRate);
+        }
+      }
+    }
+  }
+  Serial.println(F("done"));
+}
+
+void loop()
+{
+}
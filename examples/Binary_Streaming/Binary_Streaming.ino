@@ -0,0 +1,106 @@
+/*
+  Binary streaming example
+
+  Scans all six AIN channels in continuous mode and sends every pass as a
+  compact binary frame (raw codes, channel mask, sequence number, timestamp
+  and CRC, 28 bytes for six channels) instead of formatting text. Frames are
+  packed straight into a block buffer that is written out when full. The
+  scale of each channel is sent now and then in scale frames, so the host
+  can turn codes into volts with the same math as toFixed() and can join
+  the stream at any point. See extras/host/AD7794FrameDecoder for a
+  decoder.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2021  Jaimy Juliano
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <SPI.h>
+#include "NHB_AD7794.h"
+#include "NHB_AD7794Frame.h"
+
+//Pins for Feather M0 Basic Proto
+#define AD7794_CS  10
+#define EX_EN_PIN  9
+
+#define CHANNEL_COUNT   6
+#define SCALE_EVERY     256   //Data frames between repeats of the scale frames
+
+AD7794 adc(AD7794_CS, 4000000, 2.50);
+AD7794_FrameEncoder encoder((1 << CHANNEL_COUNT) - 1);
+
+uint8_t block[4 * AD7794_FRAME_MAX_SIZE];
+uint16_t blockFill = 0;
+uint32_t raw[CHANNEL_COUNT];
+
+void flushBlock()
+{
+  Serial.write(block, blockFill);
+  blockFill = 0;
+}
+
+void sendScales()
+{
+  for(uint8_t ch = 0; ch < CHANNEL_COUNT; ch++){
+    if(sizeof(block) - blockFill < AD7794_FRAME_SCALE_SIZE){
+      flushBlock();
+    }
+    blockFill += encoder.encodeScale(block + blockFill, sizeof(block) - blockFill, ch, adc.getScale(ch));
+  }
+}
+
+void setup()
+{
+  Serial.begin(921600);
+
+  while(!Serial);
+
+  pinMode(EX_EN_PIN, OUTPUT);
+  digitalWrite(EX_EN_PIN, LOW);
+
+  adc.begin();
+  adc.setUpdateRate(470);
+
+  for(uint8_t ch = 0; ch < CHANNEL_COUNT; ch++){
+    adc.setBipolar(ch, true);
+    adc.setGain(ch, 128);
+    adc.setEnabled(ch, true);
+  }
+
+  adc.setMode(AD7794_OpMode_Continuous);
+  adc.startScan();
+}
+
+void loop()
+{
+  if(encoder.getSequence() % SCALE_EVERY == 0){
+    sendScales();
+  }
+
+  adc.readScan(raw, CHANNEL_COUNT);
+
+  if(sizeof(block) - blockFill < encoder.frameSize()){
+    flushBlock();
+  }
+  blockFill += encoder.encode(block + blockFill, sizeof(block) - blockFill, raw, micros());
+}
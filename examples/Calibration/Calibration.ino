@@ -0,0 +1,125 @@
+/*
+  On-chip calibration with stored coefficients
+
+  The first time this runs (or when CAL_BUTTON_PIN is held low at reset) it
+  runs the internal zero-scale and full-scale calibrations on channel 0 and
+  saves the offset and full-scale registers to EEPROM. On every later boot
+  the coefficients are just written back to the chip, which takes a few
+  register writes instead of running the calibrations again.
+
+  Coefficients are stored per channel and gain, so calibrate again after
+  changing the gain.
+
+  Uses the EEPROM library (AVR, ESP32, ESP8266, Teensy). Boards without
+  EEPROM emulation (e.g. SAMD) need a storage class built on their flash
+  library instead; only read() and write() have to be provided.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2021  Jaimy Juliano
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <SPI.h>
+#include <EEPROM.h>
+#include "NHB_AD7794.h"
+
+//Pins for Feather M0 Basic Proto
+#define AD7794_CS       10
+#define EX_EN_PIN       9
+#define CAL_BUTTON_PIN  5   //Hold low at reset to force a new calibration
+
+#define CAL_EEPROM_ADDR 0   //Where the calibration table starts in EEPROM
+#define CAL_EEPROM_SIZE (AD7794_CAL_HEADER_SIZE + AD7794_CAL_MAX_RECORDS * AD7794_CAL_RECORD_SIZE)
+
+//Calibration storage on top of the EEPROM library
+class EepromCalStorage : public AD7794_CalStorage
+{
+  public:
+    bool read(uint16_t addr, uint8_t *buf, uint16_t len)
+    {
+      for(uint16_t i = 0; i < len; i++){
+        buf[i] = EEPROM.read(CAL_EEPROM_ADDR + addr + i);
+      }
+      return true;
+    }
+
+    bool write(uint16_t addr, const uint8_t *buf, uint16_t len)
+    {
+      for(uint16_t i = 0; i < len; i++){
+        EEPROM.write(CAL_EEPROM_ADDR + addr + i, buf[i]);
+      }
+#if defined(ESP32) || defined(ESP8266)
+      return EEPROM.commit();
+#else
+      return true;
+#endif
+    }
+};
+
+AD7794 adc(AD7794_CS, 4000000, 2.50);
+EepromCalStorage calStorage;
+
+void setup()
+{
+  Serial.begin(115200);
+
+  while(!Serial);
+
+  pinMode(CAL_BUTTON_PIN, INPUT_PULLUP);
+
+#if defined(ESP32) || defined(ESP8266)
+  EEPROM.begin(CAL_EEPROM_ADDR + CAL_EEPROM_SIZE);
+#endif
+
+  adc.begin();
+
+  adc.setUpdateRate(16.7);
+
+  adc.setBipolar(0, true);
+  adc.setGain(0, 64);
+  adc.setEnabled(0, true);
+
+  if(digitalRead(CAL_BUTTON_PIN) == HIGH && adc.restoreCalibration(calStorage) > 0){
+    Serial.println("Calibration restored");
+  }
+  else{
+    Serial.println("Calibrating...");
+    if(adc.calibrate(0) && adc.saveCalibration(calStorage)){
+      Serial.println("Calibration saved");
+    }
+    else{
+      Serial.println("Calibration failed");
+    }
+  }
+
+  Serial.print("Offset reg: 0x");
+  Serial.println(adc.getOffsetReg(0), HEX);
+  Serial.print("Full-scale reg: 0x");
+  Serial.println(adc.getFullScaleReg(0), HEX);
+}
+
+void loop()
+{
+  Serial.println(adc.read(0), DEC);
+  delay(500);
+}
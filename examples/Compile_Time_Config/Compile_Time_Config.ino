@@ -0,0 +1,77 @@
+/*
+  Compile-time configured driver
+
+  When the channel setup of a rig never changes, AD7794T takes it as
+  template parameters. Register words, settling times and scale factors
+  are then worked out by the compiler, the read over all channels is
+  unrolled, and the driver object itself takes no RAM.
+
+  Here: channels 0 and 1 bipolar at gain 128, channel 2 unipolar at gain 1,
+  all at 16.7 Hz (50 and 60 Hz rejection).
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2021  Jaimy Juliano
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <SPI.h>
+#include "NHB_AD7794T.h"
+
+//Pins for Feather M0 Basic Proto
+#define AD7794_CS  10
+#define EX_EN_PIN  9
+
+typedef AD7794T<AD7794_CS, AD7794_Setup<AD7794_rateCode(16.7)>,
+                AD7794_Ch<0, 128>,
+                AD7794_Ch<1, 128>,
+                AD7794_Ch<2, 1, false> > Adc;
+
+int32_t readings[Adc::channelCount];
+
+void setup()
+{
+  Serial.begin(115200);
+
+  while(!Serial);
+
+  pinMode(EX_EN_PIN, OUTPUT);
+  digitalWrite(EX_EN_PIN, LOW);
+
+  Adc::begin();
+}
+
+void loop()
+{
+  Adc::readAllFixed(readings);
+
+  for(uint8_t i = 0; i < Adc::channelCount; i++){
+    if(readings[i] == AD7794_FIXED_ERROR){
+      Serial.print("timeout");
+    }
+    else{
+      Serial.print(readings[i] / 256.0, 2); //Microvolts
+    }
+    Serial.print('\t');
+  }
+  Serial.println();
+}
@@ -1,10 +1,9 @@
 /*
   Reads 1 channel in continuous mode at the maximum rate of 470 sps
 
-  IMPORTANT! Continuous mode can only be used on one channel at a time, 
-  and it will not allow sharing of the SPI bus while active. Do not use 
-  this on any device that shares the same bus with other critical hardware.
-  Because of this, continuous mode is not very practical for many applications.  
+  Continuous mode reads a single channel at the full update rate. To cycle
+  through several channels in continuous mode, enable them and use
+  read(buf,size) or the scan engine (startScan()/pollScan()) instead.
 
   The readings are taken in bipolar mode with a gain of 128. This would be 
   appropriate for most full bridge type sensors like load cells and pressure gauges
@@ -0,0 +1,103 @@
+/*
+  Fixed point scaling example
+
+  Reads channel 0 and converts the same raw result two ways: with the float
+  rawToVolts() and with the integer only toFixed(), which returns microvolts
+  with AD7794_FIXED_FRAC_BITS fraction bits. It also times both conversions
+  over a buffer of raw codes, which shows the difference on boards without
+  an FPU (AVR, M0).
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2021  Jaimy Juliano
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <SPI.h>
+#include "NHB_AD7794.h"
+
+//Pins for Feather M0 Basic Proto
+#define AD7794_CS  10
+#define EX_EN_PIN  9
+
+#define BUF_SIZE   64
+
+AD7794 adc(AD7794_CS, 4000000, 2.50);
+
+uint32_t raw[BUF_SIZE];
+int32_t fixedOut[BUF_SIZE];
+volatile float floatSink;
+
+void setup()
+{
+  Serial.begin(115200);
+
+  while(!Serial);
+
+  pinMode(EX_EN_PIN, OUTPUT);
+  digitalWrite(EX_EN_PIN, LOW);
+
+  adc.begin();
+
+  adc.setUpdateRate(16.7);
+
+  adc.setBipolar(0, true);
+  adc.setGain(0, 128);
+  adc.setEnabled(0, true);
+
+  //Time both paths on a buffer of real readings
+  for(uint8_t i = 0; i < BUF_SIZE; i++){
+    raw[i] = adc.getReadingRaw(0);
+  }
+
+  uint32_t t0 = micros();
+  for(uint8_t i = 0; i < BUF_SIZE; i++){
+    floatSink = adc.rawToVolts(0, raw[i]);
+  }
+  uint32_t t1 = micros();
+  adc.convert(0, raw, fixedOut, BUF_SIZE);
+  uint32_t t2 = micros();
+
+  Serial.print("rawToVolts: ");
+  Serial.print((float)(t1 - t0) / BUF_SIZE);
+  Serial.println(" us per sample");
+  Serial.print("convert:    ");
+  Serial.print((float)(t2 - t1) / BUF_SIZE);
+  Serial.println(" us per sample");
+}
+
+void loop()
+{
+  uint32_t r = adc.getReadingRaw(0);
+
+  float volts = adc.rawToVolts(0, r);
+  int32_t uvFixed = adc.toFixed(0, r);
+
+  Serial.print(volts * 1e6, 3);
+  Serial.print(" uV\t");
+  Serial.print(uvFixed >> AD7794_FIXED_FRAC_BITS); //Whole microvolts
+  Serial.print(" uV (");
+  Serial.print(uvFixed);
+  Serial.println(" raw fixed)");
+
+  delay(500);
+}
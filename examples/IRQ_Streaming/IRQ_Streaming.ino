@@ -0,0 +1,90 @@
+/*
+  Interrupt driven streaming at 470 sps
+
+  Channel 0 is converted continuously. Every result is read from the DRDY
+  interrupt into a ring buffer, and loop() drains it in batches while it is
+  busy printing. No CPU time is spent polling the ADC.
+
+  DOUT/RDY (MISO) must also be connected to an interrupt capable pin, set
+  with DRDY_PIN below. On some boards MISO itself can be used.
+
+  IMPORTANT! CS is held low and the SPI bus stays in use while streaming.
+  Do not use this with other devices on the same bus.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2021  Jaimy Juliano
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <SPI.h>
+#include "NHB_AD7794.h"
+
+//Pins for Feather M0 Basic Proto
+#define AD7794_CS  10
+#define EX_EN_PIN  9
+#define DRDY_PIN   11  //Jumpered to MISO
+
+AD7794 adc(AD7794_CS, 4000000, 2.50);
+
+AD7794_SampleRing<64> ring;
+AD7794_Sample batch[16];
+
+void setup()
+{
+  Serial.begin(115200);
+
+  while(!Serial);
+
+  pinMode(EX_EN_PIN, OUTPUT);
+  digitalWrite(EX_EN_PIN, LOW);
+
+  adc.begin();
+
+  adc.setUpdateRate(470);
+
+  adc.setBipolar(0, true);
+  adc.setGain(0, 128);
+  adc.setEnabled(0, true);
+
+  adc.startContinuousIRQ(0, DRDY_PIN, ring);
+}
+
+void loop()
+{
+  uint8_t n = ring.read(batch, 16);
+
+  for(uint8_t i = 0; i < n; i++){
+    Serial.print(batch[i].timestamp);
+    Serial.print('\t');
+    Serial.println(batch[i].raw);
+  }
+
+  static uint32_t lastReport = 0;
+  if(millis() - lastReport >= 1000){
+    lastReport = millis();
+    Serial.print("dropped: ");
+    Serial.print(ring.dropped());
+    Serial.print(" overruns: ");
+    Serial.println(adc.overrunCount());
+  }
+}
@@ -0,0 +1,85 @@
+/*
+  Low power logger example
+
+  Scans all six AIN channels once every 10 seconds with scanEvery() and
+  keeps the AD7794 powered down in between. The chip keeps its registers
+  while powered down, so waking it needs no begin(): the first conversion's
+  register write does it. Prints each scan with the wake latency and the
+  estimated charge.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2021  Jaimy Juliano
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <SPI.h>
+#include "NHB_AD7794.h"
+
+//Pins for Feather M0 Basic Proto
+#define AD7794_CS  10
+#define EX_EN_PIN  9
+
+#define CHANNEL_COUNT   6
+#define SCAN_INTERVAL   10000   //ms
+
+AD7794 adc(AD7794_CS, 4000000, 2.50);
+
+uint32_t raw[CHANNEL_COUNT];
+
+void setup()
+{
+  Serial.begin(115200);
+
+  while(!Serial);
+
+  pinMode(EX_EN_PIN, OUTPUT);
+  digitalWrite(EX_EN_PIN, LOW);
+
+  adc.begin();
+  adc.setUpdateRate(470);
+
+  for(uint8_t ch = 0; ch < CHANNEL_COUNT; ch++){
+    adc.setBipolar(ch, true);
+    adc.setGain(ch, 128);
+    adc.setEnabled(ch, true);
+  }
+
+  adc.setMode(AD7794_OpMode_PowerDown);
+}
+
+void loop()
+{
+  if(adc.scanEvery(SCAN_INTERVAL, raw, CHANNEL_COUNT)){
+    for(uint8_t ch = 0; ch < CHANNEL_COUNT; ch++){
+      Serial.print(adc.rawToVolts(ch, raw[ch]) * 1000.0, 4);
+      Serial.print(' ');
+    }
+    Serial.print(F("mV, wake "));
+    Serial.print(adc.getWakeLatency());
+    Serial.print(F(" us, "));
+    Serial.print(adc.getScanCharge(), 2);
+    Serial.println(F(" uC"));
+  }
+
+  //Put the MCU to sleep here for the rest of the interval
+}
@@ -0,0 +1,94 @@
+/*
+  Several AD7794s on one SPI bus
+
+  Four chips share SCK/MOSI/MISO and each has its own CS pin. AD7794Array
+  starts a conversion on every chip, releases the bus while they convert,
+  and collects each result as soon as that chip is ready. All four convert
+  at the same time, so you get four readings in the time of one.
+
+  Every chip is set up through its own AD7794 object, as usual.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2021  Jaimy Juliano
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <SPI.h>
+#include "NHB_AD7794.h"
+#include "NHB_AD7794Array.h"
+
+#define CHIP_COUNT 4
+
+const uint8_t csPins[CHIP_COUNT] = {10, 11, 12, 13};
+
+AD7794 adc0(csPins[0], 4000000, 2.50);
+AD7794 adc1(csPins[1], 4000000, 2.50);
+AD7794 adc2(csPins[2], 4000000, 2.50);
+AD7794 adc3(csPins[3], 4000000, 2.50);
+
+AD7794Array adcs;
+
+float readings[CHIP_COUNT];
+
+void setup()
+{
+  Serial.begin(115200);
+
+  while(!Serial);
+
+  //Make sure no chip is selected while the others are set up
+  for(uint8_t i = 0; i < CHIP_COUNT; i++){
+    pinMode(csPins[i], OUTPUT);
+    digitalWrite(csPins[i], HIGH);
+  }
+
+  adcs.add(adc0);
+  adcs.add(adc1);
+  adcs.add(adc2);
+  adcs.add(adc3);
+
+  adcs.begin();
+  adcs.setUpdateRate(16.7);
+
+  for(uint8_t i = 0; i < adcs.size(); i++){
+    adcs.chip(i).setBipolar(0, true);
+    adcs.chip(i).setGain(0, 128);
+    adcs.chip(i).setEnabled(0, true);
+  }
+}
+
+void loop()
+{
+  uint8_t done = adcs.read(0, readings);
+
+  for(uint8_t i = 0; i < CHIP_COUNT; i++){
+    if(done & (1 << i)){
+      Serial.print(readings[i], DEC);
+    }
+    else{
+      Serial.print("timeout");
+    }
+    Serial.print('\t');
+  }
+  Serial.println();
+}
@@ -0,0 +1,86 @@
+/*
+  Non-blocking read example
+
+  Starts a conversion on channel 0 and keeps the loop running while the
+  AD7794 converts. The SPI bus is only used for the short status checks
+  in resultReady(), so other devices on the bus are free to use it.
+
+  The slowest update rate is used here (4.17 Hz, 480 ms per reading) to
+  make the point. With the blocking read(), loop() would stall for the whole
+  conversion.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2021  Jaimy Juliano
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <SPI.h>
+#include "NHB_AD7794.h"
+
+//Pins for Feather M0 Basic Proto
+#define AD7794_CS  10
+#define EX_EN_PIN  9
+
+AD7794 adc(AD7794_CS, 4000000, 2.50);
+
+uint32_t loopCount = 0;
+
+void setup() {
+
+  Serial.begin(115200);
+
+  while(!Serial);
+
+  //Uncomment next 2 lines if Jumper configured for EX control
+  //pinMode(EX_EN_PIN, OUTPUT);
+  //digitalWrite(EX_EN_PIN,LOW);  //low  = 2.5 Vex ON
+
+  adc.begin();
+
+  adc.setUpdateRate(4.17);
+
+  adc.setBipolar(0,true);
+  adc.setGain(0,128);
+  adc.setEnabled(0,true);
+
+  adc.startReading(0);
+}
+
+void loop() {
+
+  if(adc.resultReady()){
+    float reading = adc.getResult();
+
+    Serial.print(reading,DEC);
+    Serial.print('\t');
+    Serial.print(loopCount);
+    Serial.println(" loops while converting");
+
+    loopCount = 0;
+    adc.startReading(0); //Start the next one right away
+  }
+
+  //Do other work here
+  loopCount++;
+  delay(1);
+}
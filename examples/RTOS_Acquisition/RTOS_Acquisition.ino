@@ -0,0 +1,139 @@
+/*
+  RTOS acquisition example (ESP32)
+
+  Runs the AD7794 from its own FreeRTOS task, pinned to core 1, which scans
+  three channels and publishes every result to a broadcast ring. Two
+  consumers read the ring independently: a slower averaging task and
+  loop(), which prints. The SPI bus goes through a locked transport, so
+  other devices on the bus (an SD card, a display) can share it by taking
+  the same lock around their own transactions. Settings are changed from
+  loop() with call(), which runs on the acquisition task between results.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2021  Jaimy Juliano
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <SPI.h>
+#include "NHB_AD7794.h"
+#include "NHB_AD7794Rtos.h"
+
+#define AD7794_CS  5
+#define EX_EN_PIN  17
+
+#define CHANNEL_COUNT  3
+
+AD7794_SPITransport spiPort(SPI);
+AD7794_FreeRtosLock busLock;      //Take this around any other device's SPI use
+AD7794_LockedTransport lockedPort(spiPort, busLock);
+AD7794 adc(AD7794_CS, 4000000, 2.50, lockedPort);
+
+AD7794_BroadcastRing<64> ring;
+AD7794_Acquisition acq(adc, ring);
+
+volatile float average[CHANNEL_COUNT];
+
+//Runs on the acquisition task
+void setRate(AD7794 &a, void *arg)
+{
+  a.setUpdateRate(*(float *)arg);
+}
+
+void averagingTask(void *)
+{
+  AD7794_BroadcastReader reader(ring);
+  AD7794_Sample s;
+  float sum[CHANNEL_COUNT] = {0};
+  uint16_t n[CHANNEL_COUNT] = {0};
+
+  for(;;){
+    while(reader.read(s)){
+      sum[s.channel] += adc.rawToVolts(s.channel, s.raw);
+      if(++n[s.channel] == 16){
+        average[s.channel] = sum[s.channel] / 16;
+        sum[s.channel] = 0;
+        n[s.channel] = 0;
+      }
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+  }
+}
+
+AD7794_BroadcastReader printReader(ring);
+
+void setup()
+{
+  Serial.begin(115200);
+
+  pinMode(EX_EN_PIN, OUTPUT);
+  digitalWrite(EX_EN_PIN, LOW);
+
+  //Set up before start(), from then on only through call()
+  adc.begin();
+  adc.setUpdateRate(50);
+  for(uint8_t ch = 0; ch < CHANNEL_COUNT; ch++){
+    adc.setBipolar(ch, true);
+    adc.setGain(ch, 128);
+    adc.setEnabled(ch, true);
+  }
+
+  acq.start(4096, 5, 1);
+  xTaskCreatePinnedToCore(averagingTask, "average", 4096, nullptr, 2, nullptr, 0);
+}
+
+void loop()
+{
+  static uint32_t lastPrint = 0;
+  static uint32_t lastSwitch = 0;
+  static bool fast = false;
+  static uint32_t count = 0;
+  AD7794_Sample s;
+
+  //Take what is there, print every 500 ms
+  while(printReader.read(s)){
+    count++;
+  }
+
+  if(millis() - lastPrint >= 500){
+    lastPrint = millis();
+    for(uint8_t ch = 0; ch < CHANNEL_COUNT; ch++){
+      Serial.print(average[ch] * 1000.0, 4);
+      Serial.print(' ');
+    }
+    Serial.print(F("mV, "));
+    Serial.print(count);
+    Serial.print(F(" new, "));
+    Serial.print(printReader.lost());
+    Serial.println(F(" lost"));
+    count = 0;
+  }
+
+  if(millis() - lastSwitch >= 10000){
+    lastSwitch = millis();
+    fast = !fast;
+    float rate = fast ? 242 : 50;
+    acq.call(setRate, &rate);
+  }
+
+  delay(100);
+}
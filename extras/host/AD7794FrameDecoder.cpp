@@ -0,0 +1,165 @@
+/*
+  AD7794FrameDecoder.cpp - Host side decoder for AD7794_FrameEncoder frames
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "AD7794FrameDecoder.h"
+#include <string.h>
+#include <math.h>
+
+static uint32_t getLE(const uint8_t *p, uint8_t bytes)
+{
+  uint32_t value = 0;
+  for(uint8_t i = bytes; i > 0; i--){
+    value = (value << 8) | p[i - 1];
+  }
+  return value;
+}
+
+AD7794FrameDecoder::AD7794FrameDecoder()
+{
+  fill = 0;
+  haveSequence = false;
+  nextSequence = 0;
+  frames = 0;
+  badCrc = 0;
+  lost = 0;
+  skipped = 0;
+  for(uint8_t i = 0; i < 8; i++){
+    scaleValid[i] = false;
+  }
+}
+
+void AD7794FrameDecoder::setScale(uint8_t ch, int32_t mult, int32_t offset, int32_t zero, uint8_t shift)
+{
+  if(ch < 8){
+    scale[ch].mult = mult;
+    scale[ch].offset = offset;
+    scale[ch].zero = zero;
+    scale[ch].shift = shift;
+    scaleValid[ch] = true;
+  }
+}
+
+bool AD7794FrameDecoder::feed(const uint8_t *data, size_t len, size_t &used, AD7794Frame &frame)
+{
+  used = 0;
+  while(used < len){
+    buf[fill++] = data[used++];
+    if(parse(frame)){
+      return true;
+    }
+  }
+  return false;
+}
+
+void AD7794FrameDecoder::drop(size_t n)
+{
+  memmove(buf, buf + n, fill - n);
+  fill -= n;
+}
+
+//Looks at the buffered bytes. A bad sync byte or CRC drops one byte and
+//tries again from the next one, which is how the decoder resynchronises.
+bool AD7794FrameDecoder::parse(AD7794Frame &frame)
+{
+  while(fill > 0){
+    size_t size;
+
+    if(buf[0] == AD7794_FRAME_SYNC_DATA){
+      if(fill < 2){
+        return false;
+      }
+      size = AD7794_frameSize(buf[1]);
+      if(buf[1] == 0){
+        skipped++;
+        drop(1);
+        continue;
+      }
+    }
+    else if(buf[0] == AD7794_FRAME_SYNC_SCALE){
+      size = AD7794_FRAME_SCALE_SIZE;
+    }
+    else{
+      skipped++;
+      drop(1);
+      continue;
+    }
+
+    if(fill < size){
+      return false;
+    }
+    if(AD7794_frameCrc(buf, size - 2) != getLE(buf + size - 2, 2)){
+      badCrc++;
+      skipped++;
+      drop(1);
+      continue;
+    }
+
+    if(buf[0] == AD7794_FRAME_SYNC_SCALE){
+      setScale(buf[1], (int32_t)getLE(buf + 2, 4), (int32_t)getLE(buf + 6, 4),
+               (int32_t)getLE(buf + 10, 4), buf[14]);
+      drop(size);
+      continue;
+    }
+
+    frame.mask = buf[1];
+    frame.sequence = (uint16_t)getLE(buf + 2, 2);
+    frame.timestamp = getLE(buf + 4, 4);
+    frame.count = 0;
+
+    const uint8_t *p = buf + AD7794_FRAME_HEADER_SIZE;
+    for(uint8_t ch = 0; ch < 8; ch++){
+      if(!(frame.mask & (1 << ch))){
+        continue;
+      }
+      uint8_t i = frame.count++;
+      frame.channel[i] = ch;
+      frame.raw[i] = getLE(p, 3);
+      p += 3;
+
+      if(scaleValid[ch]){
+        const Scale &s = scale[ch];
+        int32_t q = (int32_t)(((int64_t)((int32_t)frame.raw[i] - s.zero) * s.mult) >> s.shift) - s.offset;
+        frame.volts[i] = q / (double)(1L << AD7794_FRAME_FRAC_BITS) / 1e6;
+      }
+      else{
+        frame.volts[i] = NAN;
+      }
+    }
+
+    if(haveSequence && frame.sequence != nextSequence){
+      lost += (uint16_t)(frame.sequence - nextSequence);
+    }
+    haveSequence = true;
+    nextSequence = frame.sequence + 1;
+    frames++;
+
+    drop(size);
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,90 @@
+/*
+  AD7794FrameDecoder.h - Host side decoder for the binary frames written by
+  AD7794_FrameEncoder (see NHB_AD7794Frame.h for the layout).
+
+  Bytes are fed in as they arrive from the serial port, in any chunk size.
+  The decoder finds frames by their sync byte and CRC, so it can join a
+  stream at any point and skips over corrupted bytes. Scale frames update
+  the per-channel scale; data frames come out with raw codes and volts,
+  computed with the same integer math as AD7794::toFixed(). Only standard
+  C++ is used, so it can be dropped into any PC program.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef AD7794_FRAME_DECODER_h
+#define AD7794_FRAME_DECODER_h
+
+#include "NHB_AD7794Frame.h"
+
+struct AD7794Frame
+{
+  uint8_t mask;
+  uint16_t sequence;
+  uint32_t timestamp;
+  uint8_t count;
+  uint8_t channel[8];
+  uint32_t raw[8];
+  double volts[8];      //NAN for channels without a scale yet
+};
+
+class AD7794FrameDecoder
+{
+  public:
+    AD7794FrameDecoder();
+
+    //Returns true and fills frame when a data frame was completed. Call
+    //again with the rest of the input (data + used, len - used) until all
+    //of it is used.
+    bool feed(const uint8_t *data, size_t len, size_t &used, AD7794Frame &frame);
+
+    void setScale(uint8_t ch, int32_t mult, int32_t offset, int32_t zero, uint8_t shift);
+    bool hasScale(uint8_t ch) const { return ch < 8 && scaleValid[ch]; }
+
+    uint32_t frameCount() const { return frames; }
+    uint32_t crcErrors() const { return badCrc; }
+    uint32_t lostFrames() const { return lost; }      //From sequence gaps
+    uint32_t skippedBytes() const { return skipped; } //Not part of any frame
+
+  private:
+    bool parse(AD7794Frame &frame);
+    void drop(size_t n);
+
+    uint8_t buf[AD7794_FRAME_MAX_SIZE];
+    size_t fill;
+
+    struct Scale { int32_t mult, offset, zero; uint8_t shift; };
+    Scale scale[8];
+    bool scaleValid[8];
+
+    bool haveSequence;
+    uint16_t nextSequence;
+    uint32_t frames;
+    uint32_t badCrc;
+    uint32_t lost;
+    uint32_t skipped;
+};
+
+#endif
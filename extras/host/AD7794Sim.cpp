@@ -0,0 +1,522 @@
+/*
+  AD7794Sim.cpp - Behavioural model of an AD7794 on the host SPI bus.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <math.h>
+#include "AD7794Sim.h"
+
+//Register select (RS2..RS0) values
+#define RS_STATUS   0
+#define RS_MODE     1
+#define RS_CONF     2
+#define RS_DATA     3
+#define RS_ID       4
+#define RS_IO       5
+#define RS_OFFSET   6
+#define RS_FS       7
+
+#define MODE_MD(m)        ((m) >> 13)
+#define MODE_CHOP_DIS     0x0010
+#define MODE_FS(m)        ((m) & 0x000F)
+
+#define POR_MODE_REG      0x000A
+#define POR_CONF_REG      0x0710
+#define POR_OFFSET_REG    0x800000
+#define POR_FS_REG        0x555555  //Factory calibrated, gain 1
+
+#define AD7794_ID         0x0F
+#define INTERNAL_REF_V    1.17
+#define RESET_BUSY_NS     500000ULL
+
+//fADC (Hz) and tSETTLE with chop enabled (ms) for FS3..FS0, from the datasheet
+static const double updateRate[16] = {
+  470, 470, 242, 123, 62, 50, 39, 33.2, 19.6, 16.7, 16.7, 12.5, 10, 8.33, 6.25, 4.17
+};
+static const double settleMs[16] = {
+  4, 4, 8, 16, 32, 40, 48, 60, 101, 120, 120, 160, 200, 240, 320, 480
+};
+
+
+AD7794Sim::AD7794Sim(uint8_t csPin, double refIn1, double refIn2)
+  : cs(csPin), selected(false), readyAt(0), now(0), refIn1(refIn1), refIn2(refIn2),
+    tempC(25.0), avdd(3.3), noiseLsb(0.0), rng(0x1234567), conversions(0), resets(0),
+    calibrations(0), writesToDrop(0), powered(0), powerMark(0)
+{
+  rs = 0;
+  bytesLeft = 0;
+  shift = 0;
+  for(uint8_t i = 0; i < AD7794SIM_INPUT_COUNT; i++){
+    vin[i] = 0.0;
+    offsetErr[i] = 0.0;
+    gainErr[i] = 0.0;
+  }
+  powerOnReset();
+  resets = 0;
+  HostSim::attach(this);
+}
+
+AD7794Sim::~AD7794Sim()
+{
+  HostSim::detach(this);
+}
+
+void AD7794Sim::setInput(uint8_t ch, double volts)
+{
+  if(ch < AD7794SIM_INPUT_COUNT){
+    vin[ch] = volts;
+  }
+}
+
+void AD7794Sim::setTemperature(double degC) { tempC = degC; }
+void AD7794Sim::setAvdd(double volts)       { avdd = volts; }
+void AD7794Sim::setNoise(double lsbRms)     { noiseLsb = lsbRms; }
+void AD7794Sim::dropWrites(uint8_t count)   { writesToDrop = count; }
+
+void AD7794Sim::setOffsetError(uint8_t ch, double volts)
+{
+  if(ch < AD7794SIM_INPUT_COUNT){
+    offsetErr[ch] = volts;
+  }
+}
+
+void AD7794Sim::setGainError(uint8_t ch, double relative)
+{
+  if(ch < AD7794SIM_INPUT_COUNT){
+    gainErr[ch] = relative;
+  }
+}
+
+uint8_t AD7794Sim::statusReg() const
+{
+  uint8_t status = dataCh & 0x07;
+  if(!rdy) status |= 0x80;
+  if(err)  status |= 0x40;
+  return status;
+}
+
+double AD7794Sim::updateRateHz() const
+{
+  return updateRate[MODE_FS(mode)];
+}
+
+uint64_t AD7794Sim::periodNs() const
+{
+  return (uint64_t)(1e9 / updateRate[MODE_FS(mode)]);
+}
+
+uint64_t AD7794Sim::settleNs() const
+{
+  //Without chop the filter settles in a single conversion period
+  if(mode & MODE_CHOP_DIS){
+    return periodNs();
+  }
+  return (uint64_t)(settleMs[MODE_FS(mode)] * 1e6);
+}
+
+void AD7794Sim::powerOnReset()
+{
+  phase = PhaseCmd;
+  onesCount = 0;
+  creadByte = 0;
+  mode = POR_MODE_REG;
+  conf = POR_CONF_REG;
+  io = 0;
+  data = 0;
+  dataCh = 0;
+  err = false;
+  for(uint8_t i = 0; i < AD7794SIM_INPUT_COUNT; i++){
+    offsetReg[i] = POR_OFFSET_REG;
+    fullScaleReg[i] = POR_FS_REG;
+  }
+  busyUntil = now + RESET_BUSY_NS;
+  calMode = 0;
+  resets++;
+
+  //Power-on mode is continuous conversion
+  startConversion(busyUntil);
+}
+
+
+//////// Serial interface /////////////////
+
+void AD7794Sim::select(bool asserted)
+{
+  selected = asserted;
+  if(!asserted){
+    //CS high resets the serial interface, but continuous read mode
+    //stays on until it is exited with 0x58 or a reset
+    if(phase == PhaseCRead){
+      creadByte = 0;
+    }
+    else{
+      phase = PhaseCmd;
+    }
+  }
+}
+
+bool AD7794Sim::dout() const
+{
+  return !rdy; //DOUT/RDY doubles as the ready flag between transfers
+}
+
+uint8_t AD7794Sim::exchange(uint8_t mosi)
+{
+  if(now < busyUntil){
+    return 0xFF;
+  }
+
+  //32 consecutive 1s on DIN reset the part from any state
+  if(mosi == 0xFF){
+    onesCount += 8;
+    if(onesCount >= 32){
+      powerOnReset();
+      return 0xFF;
+    }
+  }
+  else{
+    onesCount = 0;
+  }
+
+  uint8_t out = 0xFF;
+
+  switch(phase){
+    case PhaseCmd:
+      out = rdy ? 0x00 : 0xFF;
+      if(mosi & 0x80){
+        break; //WEN must be 0 for the write to take effect
+      }
+      rs = (mosi >> 3) & 0x07;
+      bytesLeft = regSize(rs);
+      if((mosi & 0x40) && rs == RS_DATA && (mosi & 0x04)){
+        phase = PhaseCRead; //CREAD, data follows every RDY without a command
+        creadByte = 0;
+      }
+      else if(mosi & 0x40){
+        shift = readReg(rs);
+        phase = PhaseRead;
+      }
+      else if(rs != RS_STATUS){
+        shift = 0;
+        phase = PhaseWrite;
+      }
+      break;
+
+    case PhaseRead:
+      bytesLeft--;
+      out = (shift >> (8 * bytesLeft)) & 0xFF;
+      if(bytesLeft == 0){
+        phase = PhaseCmd;
+        if(rs == RS_DATA){
+          rdy = false; //Reading the data register clears RDY
+        }
+      }
+      break;
+
+    case PhaseCRead:
+      if(creadByte == 0 && mosi == 0x58){
+        //Exit command, the current word is then read out normally
+        rs = RS_DATA;
+        bytesLeft = 3;
+        shift = data;
+        phase = PhaseRead;
+        out = rdy ? 0x00 : 0xFF;
+        break;
+      }
+      if(creadByte == 0){
+        shift = data;
+      }
+      out = (shift >> (8 * (2 - creadByte))) & 0xFF;
+      if(++creadByte == 3){
+        creadByte = 0;
+        rdy = false;
+      }
+      break;
+
+    case PhaseWrite:
+      shift = (shift << 8) | mosi;
+      if(--bytesLeft == 0){
+        phase = PhaseCmd;
+        writeReg(rs, shift);
+      }
+      break;
+  }
+  return out;
+}
+
+uint8_t AD7794Sim::regSize(uint8_t reg) const
+{
+  static const uint8_t sizes[8] = {1, 2, 2, 3, 1, 1, 3, 3};
+  return sizes[reg & 0x07];
+}
+
+uint32_t AD7794Sim::readReg(uint8_t reg) const
+{
+  uint8_t ch = conf & 0x0F;
+
+  switch(reg){
+    case RS_STATUS: return statusReg();
+    case RS_MODE:   return mode;
+    case RS_CONF:   return conf;
+    case RS_DATA:   return data;
+    case RS_ID:     return AD7794_ID;
+    case RS_IO:     return io;
+    case RS_OFFSET: return ch < AD7794SIM_INPUT_COUNT ? offsetReg[ch] : POR_OFFSET_REG;
+    case RS_FS:     return ch < AD7794SIM_INPUT_COUNT ? fullScaleReg[ch] : POR_FS_REG;
+  }
+  return 0;
+}
+
+void AD7794Sim::writeReg(uint8_t reg, uint32_t value)
+{
+  uint8_t ch = conf & 0x0F;
+
+  if(writesToDrop > 0 && (reg == RS_MODE || reg == RS_CONF)){
+    writesToDrop--;
+    return;
+  }
+
+  switch(reg){
+    case RS_MODE:
+      mode = value;
+      calMode = 0;
+      if(MODE_MD(mode) <= 1){
+        startConversion(now);
+      }
+      else if(MODE_MD(mode) >= 4){
+        //Calibration, RDY goes high and returns low when it is done.
+        //Zero-scale takes one settling time, full-scale two.
+        converting = false;
+        rdy = false;
+        calMode = MODE_MD(mode);
+        calDone = now + ((calMode & 1) ? 2 : 1) * settleNs();
+      }
+      else{
+        converting = false;
+      }
+      break;
+
+    case RS_CONF:
+      conf = value;
+      if(converting){
+        startConversion(now); //Channel change resets the filter
+      }
+      break;
+
+    case RS_IO:
+      io = value;
+      break;
+
+    case RS_OFFSET:
+      if(ch < AD7794SIM_INPUT_COUNT) offsetReg[ch] = value;
+      break;
+
+    case RS_FS:
+      if(ch < AD7794SIM_INPUT_COUNT) fullScaleReg[ch] = value;
+      break;
+  }
+}
+
+
+//////// Conversions /////////////////
+
+void AD7794Sim::startConversion(uint64_t at)
+{
+  converting = true;
+  rdy = false;
+  nextReady = at + settleNs();
+}
+
+void AD7794Sim::advanceTo(uint64_t nowNs)
+{
+  now = nowNs;
+  while(converting && nextReady <= now){
+    accountPower(nextReady);
+    completeConversion();
+  }
+  if(calMode != 0 && calDone <= now){
+    completeCalibration();
+  }
+  accountPower(now);
+}
+
+//Power-down mode, or single conversion mode once the result is in, draws
+//next to nothing. Everything else (continuous, idle, calibration) counts.
+void AD7794Sim::accountPower(uint64_t t)
+{
+  if(t <= powerMark){
+    return;
+  }
+  bool down = MODE_MD(mode) == 3 || (MODE_MD(mode) == 1 && !converting);
+  if(!down){
+    powered += t - powerMark;
+  }
+  powerMark = t;
+}
+
+uint64_t AD7794Sim::nextEventNs() const
+{
+  if(calMode != 0){
+    return calDone;
+  }
+  return converting ? nextReady : UINT64_MAX;
+}
+
+//Internal cals short the input (zero) or apply vref/gain (full-scale).
+//System cals use whatever is on the input.
+void AD7794Sim::completeCalibration()
+{
+  uint8_t ch = conf & 0x0F;
+  double gain = 1 << ((conf >> 8) & 0x07);
+  bool unipolar = conf & 0x1000;
+  uint8_t refSel = (conf >> 6) & 0x03;
+  double vref = refSel == 0 ? refIn1 : (refSel == 1 ? refIn2 : INTERNAL_REF_V);
+  double zero = unipolar ? 0.0 : 8388608.0;
+
+  if(ch < AD7794SIM_INPUT_COUNT){
+    switch(calMode){
+      case 4: //Internal zero-scale
+        offsetReg[ch] = (uint32_t)lround(POR_OFFSET_REG + analogCode(ch, 0.0) - zero);
+        break;
+      case 6: //System zero-scale
+        offsetReg[ch] = (uint32_t)lround(POR_OFFSET_REG + analogCode(ch, vin[ch]) - zero);
+        break;
+      case 5: //Internal full-scale
+      case 7: //System full-scale
+      {
+        double v = (calMode == 5) ? vref / gain : vin[ch];
+        double span = analogCode(ch, v) - zero - ((double)offsetReg[ch] - POR_OFFSET_REG);
+        double ideal = (unipolar ? 16777216.0 : 8388608.0) * v * gain / vref;
+        if(span > 0){
+          fullScaleReg[ch] = (uint32_t)lround(POR_FS_REG * ideal / span);
+        }
+        break;
+      }
+    }
+  }
+
+  calMode = 0;
+  calibrations++;
+  mode = (mode & 0x1FFF) | (2 << 13); //Back to idle
+  rdy = true;
+}
+
+void AD7794Sim::completeConversion()
+{
+  data = sampleCode();
+  dataCh = conf & 0x07;
+  rdy = true;
+  readyAt = nextReady;
+  conversions++;
+
+  if(MODE_MD(mode) == 1){
+    converting = false; //Single conversion, back to power-down
+  }
+  else{
+    nextReady += periodNs();
+  }
+}
+
+uint32_t AD7794Sim::sampleCode()
+{
+  uint8_t ch = conf & 0x0F;
+  double gain = 1 << ((conf >> 8) & 0x07);
+  bool unipolar = conf & 0x1000;
+  uint8_t refSel = (conf >> 6) & 0x03;
+  double vref = refSel == 0 ? refIn1 : (refSel == 1 ? refIn2 : INTERNAL_REF_V);
+  double v = 0.0;
+
+  if(ch < AD7794SIM_INPUT_COUNT){
+    v = vin[ch];
+  }
+  else if(ch == 6){ //Temperature sensor, forces gain 1 and internal ref
+    v = 0.00081 * (tempC + 273.0);
+    gain = 1;
+    vref = INTERNAL_REF_V;
+  }
+  else if(ch == 7){ //AVDD monitor, 1/6 attenuator
+    v = avdd / 6.0;
+    gain = 1;
+    vref = INTERNAL_REF_V;
+  }
+
+  double x;
+  if(ch < AD7794SIM_INPUT_COUNT){
+    x = correctedCode(ch, analogCode(ch, v) + noiseLsb * gaussian());
+  }
+  else{
+    x = unipolar ? 16777216.0 * (v * gain / vref)
+                 : 8388608.0 * (1.0 + v * gain / vref);
+    x += noiseLsb * gaussian();
+  }
+
+  err = false;
+  if(x < 0){
+    x = 0;
+    err = true;
+  }
+  else if(x > 16777215.0){
+    x = 16777215.0;
+    err = true;
+  }
+  return (uint32_t)lround(x);
+}
+
+//Modulator output for an external channel before offset and full-scale
+//correction, including the front-end offset and gain errors
+double AD7794Sim::analogCode(uint8_t ch, double volts) const
+{
+  double gain = (1 << ((conf >> 8) & 0x07)) * (1.0 + gainErr[ch]);
+  bool unipolar = conf & 0x1000;
+  uint8_t refSel = (conf >> 6) & 0x03;
+  double vref = refSel == 0 ? refIn1 : (refSel == 1 ? refIn2 : INTERNAL_REF_V);
+  double v = volts + offsetErr[ch];
+
+  return unipolar ? 16777216.0 * (v * gain / vref)
+                  : 8388608.0 * (1.0 + v * gain / vref);
+}
+
+//Applies the offset and full-scale registers of the channel
+double AD7794Sim::correctedCode(uint8_t ch, double code) const
+{
+  double zero = (conf & 0x1000) ? 0.0 : 8388608.0;
+
+  return zero + (code - zero - ((double)offsetReg[ch] - POR_OFFSET_REG))
+              * ((double)fullScaleReg[ch] / POR_FS_REG);
+}
+
+//Cheap deterministic N(0,1): sum of 4 uniforms from a xorshift32
+double AD7794Sim::gaussian()
+{
+  double sum = 0.0;
+  for(uint8_t i = 0; i < 4; i++){
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    sum += (double)rng / 4294967296.0;
+  }
+  return (sum - 2.0) * 1.7320508;
+}
@@ -0,0 +1,153 @@
+/*
+  AD7794Sim.h - Behavioural model of an AD7794 on the host SPI bus.
+
+  Models the serial interface (communications register, 32-ones reset),
+  the status, mode, configuration, data, ID, IO, offset and full-scale
+  registers, and conversion timing: RDY goes low 1/fADC after the previous
+  result in continuous mode, and tSETTLE after a mode write or a
+  configuration (channel) write. Settling is 2/fADC with chop enabled and
+  1/fADC with chop disabled. Analog inputs are set directly in volts.
+  The four calibration modes compute the offset and full-scale registers
+  from a modelled front-end offset and gain error, then drop to idle.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef AD7794_SIM_h
+#define AD7794_SIM_h
+
+#include "HostSim.h"
+
+#define AD7794SIM_INPUT_COUNT  6
+
+class AD7794Sim : public HostSpiDevice
+{
+  public:
+    AD7794Sim(uint8_t csPin, double refIn1 = 2.5, double refIn2 = 2.5);
+    ~AD7794Sim();
+
+    //Analog front end
+    void setInput(uint8_t ch, double volts);  //Differential AIN(+) - AIN(-)
+    void setTemperature(double degC);         //Read back on channel 6
+    void setAvdd(double volts);               //Read back on channel 7
+    void setNoise(double lsbRms);             //Gaussian noise added to every code
+    void setOffsetError(uint8_t ch, double volts);   //Front-end offset, removed by zero-scale cal
+    void setGainError(uint8_t ch, double relative);  //e.g. 0.001 = +0.1%, removed by full-scale cal
+
+    //Fault injection
+    void dropWrites(uint8_t count);           //Ignore the next count mode/conf writes (a glitch on DIN)
+
+    //Register and timing inspection
+    uint16_t modeReg() const { return mode; }
+    uint16_t confReg() const { return conf; }
+    uint8_t statusReg() const;
+    bool isReady() const { return rdy; }
+    bool inContinuousRead() const { return phase == PhaseCRead; }
+    double updateRateHz() const;
+    uint64_t settleNs() const;
+    uint64_t periodNs() const;
+
+    uint32_t conversionCount() const { return conversions; }
+    uint64_t lastReadyNs() const { return readyAt; }  //When RDY last went low
+    uint32_t resetCount() const { return resets; }
+    uint32_t calibrationCount() const { return calibrations; }
+    uint64_t poweredNs() const { return powered; }  //Time spent out of power-down
+    uint32_t offsetRegister(uint8_t ch) const { return offsetReg[ch]; }
+    uint32_t fullScaleRegister(uint8_t ch) const { return fullScaleReg[ch]; }
+
+    //HostSpiDevice
+    uint8_t csPin() const { return cs; }
+    void select(bool asserted);
+    uint8_t exchange(uint8_t mosi);
+    bool dout() const;
+    void advanceTo(uint64_t nowNs);
+    uint64_t nextEventNs() const;
+
+  private:
+    enum Phase { PhaseCmd, PhaseWrite, PhaseRead, PhaseCRead };
+
+    void powerOnReset();
+    void writeReg(uint8_t rs, uint32_t value);
+    uint32_t readReg(uint8_t rs) const;
+    uint8_t regSize(uint8_t rs) const;
+    void startConversion(uint64_t at);
+    void completeConversion();
+    uint32_t sampleCode();
+    double analogCode(uint8_t ch, double volts) const;
+    double correctedCode(uint8_t ch, double code) const;
+    void completeCalibration();
+    void accountPower(uint64_t t);
+    double gaussian();
+
+    uint8_t cs;
+    bool selected;
+
+    //Serial interface state
+    Phase phase;
+    uint8_t rs;
+    uint8_t bytesLeft;
+    uint32_t shift;
+    uint8_t onesCount;
+    uint8_t creadByte;    //Position inside the 24 bit word in continuous read
+    uint64_t busyUntil;   //No access for 500 us after a reset
+
+    //Registers
+    uint16_t mode;
+    uint16_t conf;
+    uint8_t io;
+    uint32_t data;
+    uint8_t dataCh;
+    bool err;
+    uint32_t offsetReg[AD7794SIM_INPUT_COUNT];
+    uint32_t fullScaleReg[AD7794SIM_INPUT_COUNT];
+
+    //Conversion state
+    bool converting;
+    bool rdy;
+    uint64_t nextReady;
+    uint64_t readyAt;
+    uint64_t now;
+    uint8_t calMode;      //MD value of the running calibration, 0 if none
+    uint64_t calDone;
+
+    //Analog world
+    double refIn1, refIn2;
+    double vin[AD7794SIM_INPUT_COUNT];
+    double tempC;
+    double avdd;
+    double noiseLsb;
+    double offsetErr[AD7794SIM_INPUT_COUNT];
+    double gainErr[AD7794SIM_INPUT_COUNT];
+    uint32_t rng;
+
+    uint32_t conversions;
+    uint32_t resets;
+    uint32_t calibrations;
+    uint8_t writesToDrop;
+    uint64_t powered;
+    uint64_t powerMark;   //Time up to which powered has been counted
+};
+
+#endif
@@ -0,0 +1,243 @@
+/*
+  BenchSweep.cpp - Throughput and latency sweep, see BenchSweep.h.
+
+  For each case the driver reads `samples` results, after one warm-up
+  result, the way a sketch would: getReadingRaw() round the enabled
+  channels in single conversion mode, the scan engine (pollScan(),
+  sleeping for getScanWait()) in continuous mode. Reported per case:
+
+    sps        achieved samples per second, all channels together
+    expected   what the chip allows: the update rate for one channel in
+               continuous mode, 1/tSETTLE otherwise (every sample follows a
+               mode or channel write)
+    eff        sps / expected
+    bus        share of the time the bus was clocking bytes
+    interval   time from asking for a sample to having it (percentiles):
+               the getReadingRaw() call, or the wait since the previous
+               sample in continuous mode. Same as the Benchmark_Sweep sketch.
+    ready      time from RDY going low to the sample being returned, the
+               driver's own polling latency (host only)
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+#include "NHB_AD7794.h"
+#include "AD7794Sim.h"
+#include "BenchSweep.h"
+
+#define SWEEP_CS  10
+
+//One per FS code that setUpdateRate() can select. Codes 9 and 10 are both
+//16.7 Hz (80 dB 50 Hz vs 65 dB 50/60 Hz rejection); the rate maps to 10.
+static const double sweepRates[] = {
+  470, 242, 123, 62, 50, 39, 33.2, 19.6, 16.7, 12.5, 10, 8.33, 6.25, 4.17
+};
+
+struct SweepRow
+{
+  uint8_t rateCode;
+  float nominalHz;
+  bool continuous;
+  bool chop;
+  uint8_t channels;
+  uint32_t samples;
+  double sps;
+  double expected;
+  double busPct;
+  double bytesPerSmp;
+  uint32_t interval[4];   //p50, p90, p99, max, us
+  uint32_t ready[4];
+};
+
+static void percentiles(std::vector<uint32_t> &v, uint32_t *out)
+{
+  std::sort(v.begin(), v.end());
+  size_t n = v.size();
+  out[0] = v[n / 2];
+  out[1] = v[(n * 9) / 10];
+  out[2] = v[(n * 99) / 100];
+  out[3] = v[n - 1];
+}
+
+static void printRow(BenchSweepFormat format, const SweepRow &r, bool first)
+{
+  const char *mode = r.continuous ? "continuous" : "single";
+  switch(format){
+    case SweepCsv:
+      printf("%u,%.2f,%s,%u,%u,%u,%.2f,%.2f,%.3f,%.2f,%.2f,%u,%u,%u,%u,%u,%u,%u,%u\n",
+             r.rateCode, r.nominalHz, mode, r.chop, r.channels, r.samples, r.sps, r.expected,
+             r.sps / r.expected, r.busPct, r.bytesPerSmp,
+             r.interval[0], r.interval[1], r.interval[2], r.interval[3],
+             r.ready[0], r.ready[1], r.ready[2], r.ready[3]);
+      break;
+    case SweepJson:
+      printf("%s\n  {\"rate_code\": %u, \"nominal_hz\": %.2f, \"mode\": \"%s\", \"chop\": %s, "
+             "\"channels\": %u, \"samples\": %u, \"sps\": %.2f, \"expected_sps\": %.2f, "
+             "\"efficiency\": %.3f, \"bus_pct\": %.2f, \"bytes_per_sample\": %.2f, "
+             "\"interval_us\": {\"p50\": %u, \"p90\": %u, \"p99\": %u, \"max\": %u}, "
+             "\"ready_us\": {\"p50\": %u, \"p90\": %u, \"p99\": %u, \"max\": %u}}",
+             first ? "" : ",", r.rateCode, r.nominalHz, mode, r.chop ? "true" : "false", r.channels,
+             r.samples, r.sps, r.expected, r.sps / r.expected, r.busPct, r.bytesPerSmp,
+             r.interval[0], r.interval[1], r.interval[2], r.interval[3],
+             r.ready[0], r.ready[1], r.ready[2], r.ready[3]);
+      break;
+    default:
+      printf("%4u %8.2f %-10s %4s %3u %9.2f %9.2f %6.3f %6.2f %7.2f %8u %8u %8u %8u %7u %7u\n",
+             r.rateCode, r.nominalHz, mode, r.chop ? "on" : "off", r.channels, r.sps, r.expected,
+             r.sps / r.expected, r.busPct, r.bytesPerSmp,
+             r.interval[0], r.interval[1], r.interval[2], r.interval[3], r.ready[0], r.ready[2]);
+      break;
+  }
+}
+
+int runSweep(BenchSweepFormat format, uint32_t samples, double minEfficiency)
+{
+  AD7794Sim sim(SWEEP_CS);
+  AD7794 adc(SWEEP_CS, 4000000, 2.50);
+
+  if(samples < 2){
+    samples = 2;
+  }
+  for(uint8_t ch = 0; ch < 6; ch++){
+    sim.setInput(ch, 0.001 * (ch + 1));
+  }
+  sim.setNoise(2.0);
+
+  adc.begin();
+  for(uint8_t ch = 0; ch < 6; ch++){
+    adc.setBipolar(ch, true);
+    adc.setGain(ch, 128);
+  }
+
+  switch(format){
+    case SweepCsv:
+      printf("rate_code,nominal_hz,mode,chop,channels,samples,sps,expected_sps,efficiency,bus_pct,"
+             "bytes_per_sample,interval_p50_us,interval_p90_us,interval_p99_us,interval_max_us,"
+             "ready_p50_us,ready_p90_us,ready_p99_us,ready_max_us\n");
+      break;
+    case SweepJson:
+      printf("[");
+      break;
+    default:
+      printf("%4s %8s %-10s %4s %3s %9s %9s %6s %6s %7s %8s %8s %8s %8s %7s %7s\n", "code", "Hz",
+             "mode", "chop", "ch", "sps", "expected", "eff", "bus %", "B/smp", "int p50",
+             "int p90", "int p99", "int max", "rdy p50", "rdy p99");
+      break;
+  }
+
+  int slow = 0;
+  bool first = true;
+  std::vector<uint32_t> interval, ready;
+  interval.reserve(samples);
+  ready.reserve(samples);
+
+  for(double rate : sweepRates){
+    for(uint8_t cont = 0; cont < 2; cont++){
+      for(uint8_t c = 0; c < 2; c++){
+        bool chop = (c == 0);
+        for(uint8_t n = 1; n <= 6; n++){
+          SweepRow r;
+          r.rateCode = AD7794_rateCode(rate);
+          r.continuous = cont;
+          r.chop = chop;
+          r.channels = n;
+          r.samples = samples;
+
+          adc.setUpdateRate(rate);
+          adc.setChopEnabled(chop);
+          for(uint8_t ch = 0; ch < 6; ch++){
+            adc.setEnabled(ch, ch < n);
+          }
+          adc.setMode(cont ? AD7794_OpMode_Continuous : AD7794_OpMode_SingleConv);
+          r.nominalHz = adc.getUpdateRate(0);
+
+          //The driver's busy waits cost one simulated call each, so at the slow
+          //rates each call is charged more (1/4096 of a conversion period)
+          //to keep the sweep quick. Times are good to that much.
+          uint32_t cost = (uint32_t)(1e9 / r.nominalHz / 4096);
+          HostSim::setCallCostNs(cost > 1000 ? cost : 1000);
+
+          //Polls as often as the driver's own blocking reads do
+          uint32_t gap = (uint32_t)(1e6 / r.nominalHz / 32);
+          if(gap < 20){
+            gap = 20;
+          }
+          AD7794_Sample s;
+          auto next = [&](uint32_t i){
+            if(cont){
+              while(!adc.pollScan(s)){
+                uint32_t wait = adc.getScanWait();
+                delayMicroseconds(wait ? wait : gap);
+              }
+            }
+            else{
+              adc.getReadingRaw(i % n);
+            }
+          };
+
+          if(cont){
+            adc.startScan();
+          }
+          next(0); //Warm-up, the first result also carries the mode change
+          r.expected = (cont && n == 1) ? 1e9 / sim.periodNs() : 1e9 / sim.settleNs();
+
+          interval.clear();
+          ready.clear();
+          HostSim::resetBusStats();
+          uint64_t t0 = HostSim::nowNs();
+          uint64_t last = t0;
+          for(uint32_t i = 1; i <= samples; i++){
+            next(i);
+            uint64_t now = HostSim::nowNs();
+            interval.push_back((uint32_t)((now - last) / 1000));
+            ready.push_back((uint32_t)((now - sim.lastReadyNs()) / 1000));
+            last = now;
+          }
+          uint64_t elapsed = HostSim::nowNs() - t0;
+          if(cont){
+            adc.stopScan();
+          }
+
+          const HostBusStats &bus = HostSim::busStats();
+          r.sps = samples * 1e9 / elapsed;
+          r.busPct = 100.0 * bus.busyNs / elapsed;
+          r.bytesPerSmp = (double)bus.bytes / samples;
+          percentiles(interval, r.interval);
+          percentiles(ready, r.ready);
+
+          printRow(format, r, first);
+          first = false;
+          if(r.sps < minEfficiency * r.expected){
+            slow++;
+          }
+        }
+      }
+    }
+  }
+
+  HostSim::setCallCostNs(1000);
+  if(format == SweepJson){
+    printf("\n]\n");
+  }
+  return slow;
+}
@@ -0,0 +1,37 @@
+/*
+  BenchSweep.h - Throughput and latency sweep of the AD7794 driver against
+  the simulated device, over every update rate, single vs continuous mode,
+  chop on/off and 1-6 channels. Run with bench_ad7794 --sweep.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#ifndef BENCH_SWEEP_h
+#define BENCH_SWEEP_h
+
+#include <stdint.h>
+
+enum BenchSweepFormat { SweepTable, SweepCsv, SweepJson };
+
+//Prints one row per case to stdout. Returns the number of cases whose
+//achieved rate fell below minEfficiency of the expected rate (0 to skip).
+int runSweep(BenchSweepFormat format, uint32_t samples, double minEfficiency);
+
+#endif
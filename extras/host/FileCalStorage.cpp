@@ -0,0 +1,70 @@
+/*
+  FileCalStorage.cpp - Calibration storage backed by a file.
+
+  Simulated SPI devices register themselves with HostSim::attach(). A byte
+  sent with SPI.transfer() is delivered to the device whose chip select is
+  LOW and takes 8 SCLK periods of virtual time at the clock rate given to
+  the last SPI.beginTransaction().
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#include <stdio.h>
+#include "FileCalStorage.h"
+
+FileCalStorage::FileCalStorage(const char *path) : path(path), written(0)
+{
+}
+
+//Reads past the end of the file fail, like reading blank EEPROM would
+//fail the magic check
+bool FileCalStorage::read(uint16_t addr, uint8_t *buf, uint16_t len)
+{
+  FILE *f = fopen(path, "rb");
+  if(f == nullptr){
+    return false;
+  }
+
+  bool ok = fseek(f, addr, SEEK_SET) == 0 && fread(buf, 1, len, f) == len;
+  fclose(f);
+  return ok;
+}
+
+bool FileCalStorage::write(uint16_t addr, const uint8_t *buf, uint16_t len)
+{
+  FILE *f = fopen(path, "r+b");
+  if(f == nullptr){
+    f = fopen(path, "w+b");
+  }
+  if(f == nullptr){
+    return false;
+  }
+
+  //Fill any gap up to addr with 0xFF, the erased state of EEPROM/flash
+  fseek(f, 0, SEEK_END);
+  for(long end = ftell(f); end < addr; end++){
+    fputc(0xFF, f);
+  }
+
+  bool ok = fseek(f, addr, SEEK_SET) == 0 && fwrite(buf, 1, len, f) == len;
+  fclose(f);
+  written += len;
+  return ok;
+}
@@ -0,0 +1,45 @@
+/*
+  FileCalStorage.h - Calibration storage backed by a file, the host
+  stand-in for EEPROM or flash (see AD7794::saveCalibration()).
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#ifndef FILE_CAL_STORAGE_h
+#define FILE_CAL_STORAGE_h
+
+#include "NHB_AD7794.h"
+
+class FileCalStorage : public AD7794_CalStorage
+{
+  public:
+    FileCalStorage(const char *path);
+
+    bool read(uint16_t addr, uint8_t *buf, uint16_t len);
+    bool write(uint16_t addr, const uint8_t *buf, uint16_t len);
+
+    uint32_t bytesWritten() const { return written; }
+
+  private:
+    const char *path;
+    uint32_t written;
+};
+
+#endif
@@ -0,0 +1,370 @@
+/*
+  HostArduino.cpp - Implementation of the host Arduino/SPI stand-in.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <Arduino.h>
+#include <mutex>
+#include <SPI.h>
+#include "HostSim.h"
+
+#define HOST_MAX_PINS     64
+#define HOST_MAX_DEVICES   8
+
+SPIClass SPI;
+
+static uint64_t simNow = 0;
+static uint32_t callCost = 1000;
+static uint32_t sclkHz = 4000000;
+
+static uint8_t pinLevel[HOST_MAX_PINS];
+static HostSpiDevice *devices[HOST_MAX_DEVICES];
+static uint8_t deviceCount = 0;
+static HostBusStats stats;
+
+//Interrupts, only edges on the MISO net are generated
+static void (*isrTable[HOST_MAX_PINS])(void);
+static int isrMode[HOST_MAX_PINS];
+static bool isrPending[HOST_MAX_PINS];
+static bool misoWired[HOST_MAX_PINS];
+static uint8_t misoLevel = HIGH;
+static bool irqEnabled = true;
+static bool inIsr = false;
+static uint32_t isrCount = 0;
+
+//Every entry point holds this while it touches the simulated world, so
+//threads (see the bench's shared bus section) see each call as atomic
+static std::recursive_mutex simMutex;
+#define HOST_LOCK()  std::lock_guard<std::recursive_mutex> hostLock(simMutex)
+
+static HostSpiDevice *selectedDevice();
+static void serviceInterrupts();
+
+
+//////// Virtual clock and device registry /////////////////
+
+uint64_t HostSim::nowNs()
+{
+  HOST_LOCK();
+  return simNow;
+}
+
+//Steps through every device event on the way, so that interrupts see each
+//DOUT edge at the time it happens rather than at the end of a long delay()
+void HostSim::advanceNs(uint64_t ns)
+{
+  HOST_LOCK();
+  uint64_t target = simNow + ns;
+
+  //An interrupt handler can advance the clock itself (SPI traffic), so
+  //never step backwards
+  for(;;){
+    uint64_t next = target;
+    for(uint8_t i = 0; i < deviceCount; i++){
+      uint64_t ev = devices[i]->nextEventNs();
+      if(ev > simNow && ev < next){
+        next = ev;
+      }
+    }
+    if(next > simNow){
+      simNow = next;
+    }
+    for(uint8_t i = 0; i < deviceCount; i++){
+      devices[i]->advanceTo(simNow);
+    }
+    serviceInterrupts();
+    if(simNow >= target){
+      break;
+    }
+  }
+}
+
+void HostSim::setCallCostNs(uint32_t ns)
+{
+  callCost = ns;
+}
+
+void HostSim::attach(HostSpiDevice *dev)
+{
+  HOST_LOCK();
+  if(deviceCount < HOST_MAX_DEVICES){
+    devices[deviceCount++] = dev;
+    dev->advanceTo(simNow);
+  }
+}
+
+void HostSim::detach(HostSpiDevice *dev)
+{
+  HOST_LOCK();
+  for(uint8_t i = 0; i < deviceCount; i++){
+    if(devices[i] == dev){
+      devices[i] = devices[--deviceCount];
+      return;
+    }
+  }
+}
+
+void HostSim::wireToMiso(uint8_t pin)
+{
+  if(pin < HOST_MAX_PINS){
+    misoWired[pin] = true;
+  }
+}
+
+uint32_t HostSim::isrCalls()
+{
+  return isrCount;
+}
+
+const HostBusStats &HostSim::busStats()
+{
+  return stats;
+}
+
+void HostSim::resetBusStats()
+{
+  HOST_LOCK();
+  stats = HostBusStats();
+}
+
+//Returns the one device with CS asserted, or nullptr
+static HostSpiDevice *selectedDevice()
+{
+  HostSpiDevice *sel = nullptr;
+  for(uint8_t i = 0; i < deviceCount; i++){
+    uint8_t pin = devices[i]->csPin();
+    if(pin < HOST_MAX_PINS && pinLevel[pin] == LOW){
+      if(sel != nullptr){
+        return nullptr; //Bus contention, nobody gets a clean byte
+      }
+      sel = devices[i];
+    }
+  }
+  return sel;
+}
+
+static uint8_t misoNetLevel()
+{
+  HostSpiDevice *dev = selectedDevice();
+  return (dev == nullptr || dev->dout()) ? HIGH : LOW;
+}
+
+//Latches edges on the MISO net like an interrupt flag would, then runs the
+//handlers unless interrupts are masked or we are already inside one
+static void serviceInterrupts()
+{
+  uint8_t level = misoNetLevel();
+
+  if(level != misoLevel){
+    misoLevel = level;
+    for(uint8_t pin = 0; pin < HOST_MAX_PINS; pin++){
+      if(isrTable[pin] == nullptr || !(pin == MISO || misoWired[pin])){
+        continue;
+      }
+      if(isrMode[pin] == CHANGE ||
+         (isrMode[pin] == FALLING && level == LOW) ||
+         (isrMode[pin] == RISING && level == HIGH)){
+        isrPending[pin] = true;
+      }
+    }
+  }
+
+  if(inIsr || !irqEnabled){
+    return;
+  }
+
+  bool ran;
+  do{
+    ran = false;
+    for(uint8_t pin = 0; pin < HOST_MAX_PINS; pin++){
+      if(isrPending[pin] && isrTable[pin] != nullptr){
+        isrPending[pin] = false;
+        inIsr = true;
+        isrCount++;
+        isrTable[pin]();
+        inIsr = false;
+        ran = true;
+      }
+    }
+  }while(ran);
+}
+
+
+//////// Arduino core /////////////////
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  HOST_LOCK();
+  if(pin < HOST_MAX_PINS && mode == INPUT_PULLUP){
+    pinLevel[pin] = HIGH;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  HOST_LOCK();
+  if(pin >= HOST_MAX_PINS){
+    return;
+  }
+
+  uint8_t old = pinLevel[pin];
+  pinLevel[pin] = val ? HIGH : LOW;
+  if(old == pinLevel[pin]){
+    return;
+  }
+
+  for(uint8_t i = 0; i < deviceCount; i++){
+    if(devices[i]->csPin() == pin){
+      stats.csToggles++;
+      devices[i]->select(pinLevel[pin] == LOW);
+    }
+  }
+  serviceInterrupts();
+}
+
+int digitalRead(uint8_t pin)
+{
+  HOST_LOCK();
+  HostSim::advanceNs(callCost);
+
+  if(pin == MISO || (pin < HOST_MAX_PINS && misoWired[pin])){
+    return misoNetLevel();
+  }
+  return pin < HOST_MAX_PINS ? pinLevel[pin] : LOW;
+}
+
+unsigned long millis()
+{
+  HOST_LOCK();
+  HostSim::advanceNs(callCost);
+  return (unsigned long)(simNow / 1000000ULL);
+}
+
+unsigned long micros()
+{
+  HOST_LOCK();
+  HostSim::advanceNs(callCost);
+  return (unsigned long)(simNow / 1000ULL);
+}
+
+void delay(unsigned long ms)
+{
+  HostSim::advanceNs((uint64_t)ms * 1000000ULL);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  HostSim::advanceNs((uint64_t)us * 1000ULL);
+}
+
+void yield()
+{
+  HostSim::advanceNs(callCost);
+}
+
+//Interrupt numbers are pin numbers, see digitalPinToInterrupt()
+void attachInterrupt(uint8_t interruptNum, void (*isr)(void), int mode)
+{
+  HOST_LOCK();
+  if(interruptNum < HOST_MAX_PINS){
+    isrTable[interruptNum] = isr;
+    isrMode[interruptNum] = mode;
+    isrPending[interruptNum] = false;
+    misoLevel = misoNetLevel();
+  }
+}
+
+void detachInterrupt(uint8_t interruptNum)
+{
+  HOST_LOCK();
+  if(interruptNum < HOST_MAX_PINS){
+    isrTable[interruptNum] = nullptr;
+    isrPending[interruptNum] = false;
+  }
+}
+
+void noInterrupts()
+{
+  HOST_LOCK();
+  irqEnabled = false;
+}
+
+void interrupts()
+{
+  HOST_LOCK();
+  irqEnabled = true;
+  serviceInterrupts();
+}
+
+
+//////// SPI /////////////////
+
+void SPIClass::begin() {}
+void SPIClass::end() {}
+
+void SPIClass::beginTransaction(SPISettings settings)
+{
+  HOST_LOCK();
+  stats.transactions++;
+  if(settings.clock > 0){
+    sclkHz = settings.clock;
+  }
+}
+
+void SPIClass::endTransaction() {}
+
+void SPIClass::usingInterrupt(int interruptNumber)
+{
+  (void)interruptNumber;
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+  HOST_LOCK();
+  uint64_t byteNs = 8000000000ULL / sclkHz;
+  HostSpiDevice *dev = selectedDevice();
+  uint8_t in = (dev != nullptr) ? dev->exchange(data) : 0xFF;
+
+  stats.bytes++;
+  stats.busyNs += byteNs;
+  HostSim::advanceNs(byteNs);
+  return in;
+}
+
+uint16_t SPIClass::transfer16(uint16_t data)
+{
+  uint16_t in = transfer(highByte(data));
+  in = (in << 8) | transfer(lowByte(data));
+  return in;
+}
+
+void SPIClass::transfer(void *buf, size_t count)
+{
+  uint8_t *p = (uint8_t *)buf;
+  for(size_t i = 0; i < count; i++){
+    p[i] = transfer(p[i]);
+  }
+}
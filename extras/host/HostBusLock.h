@@ -0,0 +1,54 @@
+/*
+  HostBusLock.h - AD7794_BusLock on a std::mutex, for driving the library
+  from several std::threads on the host. Counts how often a thread had to
+  wait for another one.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#ifndef HOST_BUS_LOCK_h
+#define HOST_BUS_LOCK_h
+
+#include <atomic>
+#include <mutex>
+#include "NHB_AD7794Rtos.h"
+
+class HostBusLock : public AD7794_BusLock
+{
+  public:
+    HostBusLock() : waits(0) {}
+
+    void lock()
+    {
+      if(!mutex.try_lock()){
+        waits++;
+        mutex.lock();
+      }
+    }
+    void unlock() { mutex.unlock(); }
+
+    uint32_t contended() const { return waits.load(); }
+
+  private:
+    std::mutex mutex;
+    std::atomic<uint32_t> waits;
+};
+
+#endif
@@ -0,0 +1,87 @@
+/*
+  HostSim.h - Virtual clock, pin and SPI bus model behind the host
+  Arduino stand-in (Arduino.h / SPI.h in this directory).
+
+  Simulated SPI devices register themselves with HostSim::attach(). A byte
+  sent with SPI.transfer() is delivered to the device whose chip select is
+  LOW and takes 8 SCLK periods of virtual time at the clock rate given to
+  the last SPI.beginTransaction().
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef HOST_SIM_h
+#define HOST_SIM_h
+
+#include <stdint.h>
+
+//Counters for everything that crosses the simulated bus
+struct HostBusStats
+{
+  uint64_t bytes        = 0;  //bytes clocked by SPI.transfer()/transfer16()
+  uint64_t csToggles    = 0;  //edges on chip select pins of attached devices
+  uint64_t transactions = 0;  //SPI.beginTransaction() calls
+  uint64_t busyNs       = 0;  //time spent clocking bytes (bus occupancy)
+};
+
+//Interface implemented by every simulated SPI slave
+class HostSpiDevice
+{
+  public:
+    virtual ~HostSpiDevice() {}
+
+    virtual uint8_t csPin() const = 0;
+    virtual void select(bool asserted) = 0;     //called on every CS edge
+    virtual uint8_t exchange(uint8_t mosi) = 0; //one full byte, returns MISO
+    virtual bool dout() const = 0;              //DOUT level while selected
+    virtual void advanceTo(uint64_t nowNs) = 0; //run internal state to nowNs
+    virtual uint64_t nextEventNs() const { return UINT64_MAX; } //next DOUT change
+};
+
+namespace HostSim
+{
+  //Virtual clock, starts at 0 and only moves forward
+  uint64_t nowNs();
+  void advanceNs(uint64_t ns);
+
+  //CPU time charged for each millis()/micros()/digitalRead() call, so
+  //that busy loops make progress. Default 1 us.
+  void setCallCostNs(uint32_t ns);
+
+  void attach(HostSpiDevice *dev);
+  void detach(HostSpiDevice *dev);
+
+  //Wires an extra pin to the MISO (DOUT/RDY) net, e.g. an interrupt pin
+  //jumpered to DOUT. digitalRead() and attachInterrupt() on it see MISO.
+  void wireToMiso(uint8_t pin);
+
+  //Number of interrupt service routine calls made so far
+  uint32_t isrCalls();
+
+  const HostBusStats &busStats();
+  void resetBusStats();
+}
+
+#endif
@@ -0,0 +1,90 @@
+/*
+  MockTransport.cpp - AD7794_Transport for host tests and benchmarks
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "MockTransport.h"
+#include "HostSim.h"
+
+MockTransport::MockTransport(SPIClass &spi) : spi(spi)
+{
+  callCostNs = 0;
+  splitBulk = false;
+  tracing = false;
+}
+
+void MockTransport::charge()
+{
+  if(callCostNs > 0){
+    HostSim::advanceNs(callCostNs);
+  }
+}
+
+void MockTransport::begin()
+{
+  spi.begin();
+}
+
+void MockTransport::beginTransaction(const SPISettings &settings)
+{
+  counters.transactions++;
+  charge();
+  spi.beginTransaction(settings);
+}
+
+void MockTransport::endTransaction()
+{
+  spi.endTransaction();
+}
+
+uint8_t MockTransport::transfer(uint8_t data)
+{
+  counters.byteCalls++;
+  counters.bytes++;
+  charge();
+  if(tracing){
+    mosi.push_back(data);
+  }
+  return spi.transfer(data);
+}
+
+void MockTransport::transfer(uint8_t *buf, uint16_t len)
+{
+  if(splitBulk){
+    for(uint16_t i = 0; i < len; i++){
+      buf[i] = transfer(buf[i]);
+    }
+    return;
+  }
+
+  counters.bulkCalls++;
+  counters.bytes += len;
+  charge();
+  if(tracing){
+    mosi.insert(mosi.end(), buf, buf + len);
+  }
+  spi.transfer(buf, len);
+}
@@ -0,0 +1,81 @@
+/*
+  MockTransport.h - AD7794_Transport for host tests and benchmarks.
+
+  Forwards bytes to the simulated bus (through a host SPIClass) and counts
+  what the driver asks of its transport: single byte calls, bulk calls and
+  async calls. Each call can be charged a fixed CPU overhead in virtual
+  time, to see what bulk transfers save on a core where every call into
+  the SPI library costs something. With tracing on, every MOSI byte is
+  recorded so tests can check exactly what went out.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef MOCK_TRANSPORT_h
+#define MOCK_TRANSPORT_h
+
+#include <vector>
+#include "NHB_AD7794Transport.h"
+
+struct MockTransportStats
+{
+  uint32_t byteCalls = 0;     //transfer(uint8_t)
+  uint32_t bulkCalls = 0;     //transfer(buf, len)
+  uint32_t transactions = 0;
+  uint64_t bytes = 0;
+};
+
+class MockTransport : public AD7794_Transport
+{
+  public:
+    MockTransport(SPIClass &spi = SPI);
+
+    void begin();
+    void beginTransaction(const SPISettings &settings);
+    void endTransaction();
+    uint8_t transfer(uint8_t data);
+    void transfer(uint8_t *buf, uint16_t len);
+
+    void setCallCostNs(uint32_t ns) { callCostNs = ns; }
+    void setSplitBulk(bool split) { splitBulk = split; }   //Bulk calls go out one byte call at a time
+    void setTrace(bool enabled) { tracing = enabled; }
+    const std::vector<uint8_t> &trace() const { return mosi; }
+    void clearTrace() { mosi.clear(); }
+
+    const MockTransportStats &stats() const { return counters; }
+    void resetStats() { counters = MockTransportStats(); }
+
+  private:
+    void charge();
+
+    SPIClass &spi;
+    uint32_t callCostNs;
+    bool splitBulk;
+    bool tracing;
+    std::vector<uint8_t> mosi;
+    MockTransportStats counters;
+};
+
+#endif
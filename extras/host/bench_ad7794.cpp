@@ -0,0 +1,1073 @@
+/*
+  bench_ad7794.cpp - Host benchmark of the AD7794 driver against the
+  simulated device. Reports SPI bytes, CS toggles and transactions per
+  sample, and simulated microseconds per sample, for the public read paths.
+
+  Usage: bench_ad7794 [updateRateHz] [samples]
+         bench_ad7794 --sweep [table|csv|json] [samples] [minEfficiency]
+
+  Each section checks the values it computes (readings against the simulated
+  inputs, lost or mislabeled samples, decoded frames, restored calibration,
+  the saving it exists to show) and prints FAIL on a mismatch. The exit
+  status is the number of failed checks.
+
+  --sweep runs the throughput and latency sweep in BenchSweep.cpp instead.
+  Its exit status is the number of cases below minEfficiency (e.g. 0.9) of
+  the expected rate, for use in CI.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <math.h>
+#include "NHB_AD7794.h"
+#include "NHB_AD7794Array.h"
+#include "NHB_AD7794T.h"
+#include "NHB_AD7794Thermocouple.h"
+#include "AD7794Sim.h"
+#include "FileCalStorage.h"
+#include "NHB_AD7794Frame.h"
+#include "AD7794FrameDecoder.h"
+#include "MockTransport.h"
+#include "NHB_AD7794Rtos.h"
+#include "HostBusLock.h"
+#include "BenchSweep.h"
+
+#define BENCH_CS  10
+
+struct BenchResult
+{
+  uint32_t samples;
+  HostBusStats bus;
+  uint64_t elapsedNs;
+};
+
+static void printResult(const char *name, const BenchResult &r)
+{
+  double n = r.samples;
+  printf("%-24s %8u %10.1f %8.2f %8.2f %12.1f %7.1f%%\n",
+         name, r.samples,
+         r.bus.bytes / n,
+         r.bus.csToggles / n,
+         r.bus.transactions / n,
+         r.elapsedNs / n / 1000.0,
+         100.0 * r.bus.busyNs / (double)r.elapsedNs);
+}
+
+//Runs fn() 'calls' times, each call producing 'perCall' samples
+template <typename Fn>
+static BenchResult measure(uint32_t calls, uint32_t perCall, Fn fn)
+{
+  BenchResult r;
+  HostSim::resetBusStats();
+  uint64_t t0 = HostSim::nowNs();
+  for(uint32_t i = 0; i < calls; i++){
+    fn();
+  }
+  r.elapsedNs = HostSim::nowNs() - t0;
+  r.bus = HostSim::busStats();
+  r.samples = calls * perCall;
+  return r;
+}
+
+static unsigned failures;
+
+//Counts a result that is not what the section expects
+static void check(bool ok, const char *what)
+{
+  if(!ok){
+    printf("  FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+//A reading within 'tol' volts of the simulated input
+static bool near(double v, double want, double tol = 1e-6)
+{
+  return fabs(v - want) <= tol;
+}
+
+//DOUT shorted to ground: every byte reads 0x00, so the status byte says
+//ready (RDY low) with a result from channel 0
+class StuckLowDevice : public HostSpiDevice
+{
+  public:
+    explicit StuckLowDevice(uint8_t cs) : cs(cs) { HostSim::attach(this); }
+    ~StuckLowDevice() { HostSim::detach(this); }
+
+    uint8_t csPin() const { return cs; }
+    void select(bool asserted) { (void)asserted; }
+    uint8_t exchange(uint8_t mosi) { (void)mosi; return 0x00; }
+    bool dout() const { return false; }
+    void advanceTo(uint64_t nowNs) { (void)nowNs; }
+
+  private:
+    uint8_t cs;
+};
+
+int main(int argc, char **argv)
+{
+  if(argc > 1 && strcmp(argv[1], "--sweep") == 0){
+    const char *f = argc > 2 ? argv[2] : "table";
+    BenchSweepFormat format = strcmp(f, "csv") == 0 ? SweepCsv : strcmp(f, "json") == 0 ? SweepJson : SweepTable;
+    int slow = runSweep(format, argc > 3 ? (uint32_t)atoi(argv[3]) : 32, argc > 4 ? atof(argv[4]) : 0);
+    return slow > 125 ? 125 : slow;
+  }
+
+  double rate = argc > 1 ? atof(argv[1]) : 470;
+  uint32_t calls = argc > 2 ? (uint32_t)atoi(argv[2]) : 200;
+
+  AD7794Sim sim(BENCH_CS);
+  AD7794 adc(BENCH_CS, 4000000, 2.50);
+
+  for(uint8_t ch = 0; ch < 6; ch++){
+    sim.setInput(ch, 0.001 * (ch + 1));
+  }
+  sim.setNoise(2.0);
+
+  adc.begin();
+  adc.setUpdateRate(rate);
+  for(uint8_t ch = 0; ch < 6; ch++){
+    adc.setBipolar(ch, true);
+    adc.setGain(ch, 128);
+    adc.setEnabled(ch, true);
+  }
+
+  //Configuration traffic, 4 setters on each of 6 channels
+  auto configure = [&](uint8_t gain){
+    for(uint8_t ch = 0; ch < 6; ch++){
+      adc.setBipolar(ch, true);
+      adc.setGain(ch, gain);
+      adc.setVBias(ch, false);
+      adc.setEnabled(ch, true);
+    }
+  };
+  BenchResult cfg = measure(1, 24, [&]{ configure(64); });
+  BenchResult cfgBatch = measure(1, 24, [&]{ adc.beginConfig(); configure(128); adc.commit(); });
+
+  //Only the selected channel's setters reach the chip, so the 24 above cost
+  //one conf write either way. Gain, buffer, reference and rate on channel 0
+  //(selected) are three conf writes and a mode write when sent one by one.
+  auto configureCh0 = [&](uint8_t gain, bool buffered, uint8_t ref, double chRate){
+    adc.setGain(0, gain);
+    adc.setInputBuffer(0, buffered);
+    adc.setRefMode(0, ref);
+    adc.setUpdateRate(0, chRate);
+  };
+  BenchResult cfgCh0 = measure(1, 4, [&]{ configureCh0(64, false, AD7794_REF_EXT_2, 50); });
+  BenchResult cfgCh0Batch = measure(1, 4, [&]{
+    adc.beginConfig();
+    configureCh0(32, true, AD7794_REF_INT, 16.7);
+    adc.commit();
+  });
+  adc.beginConfig();
+  configureCh0(128, true, AD7794_REF_EXT_1, rate);
+  adc.commit();
+
+  printf("update rate %.2f Hz (sim %.2f Hz), SCLK 4 MHz\n", rate, sim.updateRateHz());
+  printf("%-24s %8s %10s %8s %8s %12s %8s\n",
+         "case", "samples", "bytes/smp", "cs/smp", "txn/smp", "us/smp", "bus");
+
+  volatile uint32_t sinkRaw = 0;
+  volatile float sinkF = 0;
+  float buf[6];
+  auto bufOk = [&]{
+    for(uint8_t ch = 0; ch < 6; ch++){
+      if(!near(buf[ch], 0.001 * (ch + 1))) return false;
+    }
+    return true;
+  };
+
+  printResult("getReadingRaw(0)", measure(calls, 1, [&]{ sinkRaw = adc.getReadingRaw(0); }));
+  check(near(adc.rawToVolts(0, sinkRaw), 0.001), "getReadingRaw(0) is not channel 0's input");
+  printResult("read(0)",          measure(calls, 1, [&]{ sinkF = adc.read(0); }));
+  check(near(sinkF, 0.001), "read(0) is not channel 0's input");
+  printResult("read(buf,6)",      measure(calls, 6, [&]{ adc.read(buf, 6); sinkF = buf[5]; }));
+  check(bufOk(), "read(buf,6) does not match the inputs");
+  adc.setMode(AD7794_OpMode_Continuous);
+  printResult("read(buf,6) continuous", measure(calls, 6, [&]{ adc.read(buf, 6); sinkF = buf[5]; }));
+  printf("  scan rate %.1f Hz per channel, last pass %.5f %.5f %.5f %.5f %.5f %.5f\n", adc.getScanRate(),
+         buf[0], buf[1], buf[2], buf[3], buf[4], buf[5]);
+  check(bufOk(), "read(buf,6) in continuous mode does not match the inputs");
+  adc.setMode(AD7794_OpMode_SingleConv);
+
+  printResult("startReading+poll/500us", measure(calls, 1, [&]{
+    adc.startReading(0);
+    while(!adc.resultReady()){
+      delayMicroseconds(500); //Other work, bus is free
+    }
+    sinkRaw = adc.getResultRaw();
+  }));
+  check(near(adc.rawToVolts(0, sinkRaw), 0.001), "getResultRaw() is not channel 0's input");
+
+  //Interrupt driven streaming, loop() busy elsewhere for 10 ms at a time
+  {
+    const uint8_t drdyPin = 5;
+    AD7794_SampleRing<32> ring;
+    AD7794_Sample batch[32];
+    uint32_t got = 0;
+
+    HostSim::wireToMiso(drdyPin);
+    adc.startContinuousIRQ(0, drdyPin, ring);
+    BenchResult r = measure(1, 1, [&]{
+      while(got < calls){
+        delay(10);
+        got += ring.read(batch, 32);
+      }
+    });
+    adc.stopContinuousIRQ();
+    r.samples = got;
+    printResult("continuous IRQ + ring", r);
+    printf("  ring dropped %u, overruns %u\n", ring.dropped(), adc.overrunCount());
+    check(got >= calls && ring.dropped() == 0 && adc.overrunCount() == 0, "IRQ ring lost samples");
+  }
+
+  //Continuous read streaming
+  {
+    static uint32_t stream[4096];
+    uint32_t n = calls < 4096 ? calls : 4096;
+    uint32_t got = 0;
+
+    adc.startStreaming(0);
+    BenchResult r = measure(1, 1, [&]{ got = adc.readStream(stream, n); });
+    adc.stopStreaming();
+    r.samples = got;
+    printResult("CREAD readStream", r);
+    uint32_t bad = 0;
+    for(uint32_t i = 0; i < got; i++){
+      if(!near(adc.rawToVolts(0, stream[i]), 0.001)) bad++;
+    }
+    check(got == n && bad == 0, "readStream() short or wrong results");
+  }
+
+  //Oversampling through the filter stage: interrupt ring traffic and noise
+  //with a median of 3 followed by an 8:1 decimator on channel 0
+  {
+    const uint8_t drdyPin = 5;
+    AD7794_SampleRing<32> ring;
+    AD7794_Sample batch[32];
+    AD7794_Median<3> median;
+    AD7794_Decimator decim(8);
+    static uint32_t out[4096];
+    uint32_t want = calls < 4096 ? calls : 4096;
+    uint32_t got = 0;
+
+    median.then(decim);
+    adc.setFilter(0, &median);
+    adc.startContinuousIRQ(0, drdyPin, ring);
+    BenchResult r = measure(1, 1, [&]{
+      while(got < want){
+        delay(10);
+        uint8_t n = ring.read(batch, 32);
+        for(uint8_t i = 0; i < n && got < want; i++){
+          out[got++] = batch[i].raw;
+        }
+      }
+    });
+    adc.stopContinuousIRQ();
+    adc.setFilter(0, nullptr);
+    r.samples = got;
+    printResult("IRQ + median3 + decim8", r);
+
+    double mean = 0, var = 0;
+    for(uint32_t i = 0; i < got; i++){
+      mean += out[i];
+    }
+    mean /= got;
+    for(uint32_t i = 0; i < got; i++){
+      var += (out[i] - mean) * (out[i] - mean);
+    }
+    printf("  output noise %.2f LSB rms (input 2.00), %u ring pushes\n", sqrt(var / got), got);
+    check(got == want && sqrt(var / got) < 1.5 && near(adc.rawToVolts(0, (uint32_t)(mean + 0.5)), 0.001),
+          "median3 + decim8 output not filtered or off the input");
+  }
+
+  //Four chips on the same bus, one after another vs interleaved
+  {
+    const uint8_t csPins[3] = {11, 12, 13};
+    for(uint8_t i = 0; i < 3; i++){
+      digitalWrite(csPins[i], HIGH); //CS idles high before the chips are set up
+    }
+
+    AD7794Sim sim1(csPins[0]), sim2(csPins[1]), sim3(csPins[2]);
+    AD7794 adc1(csPins[0], 4000000, 2.50), adc2(csPins[1], 4000000, 2.50), adc3(csPins[2], 4000000, 2.50);
+    AD7794 *all[4] = {&adc, &adc1, &adc2, &adc3};
+    AD7794Array array;
+    uint32_t raw[4];
+
+    for(uint8_t i = 0; i < 4; i++){
+      array.add(*all[i]);
+    }
+    array.begin();
+    array.setUpdateRate(rate);
+    for(uint8_t i = 0; i < 4; i++){
+      all[i]->setBipolar(0, true);
+      all[i]->setGain(0, 128);
+      all[i]->setEnabled(0, true);
+    }
+
+    BenchResult seq = measure(calls, 4, [&]{
+      for(uint8_t i = 0; i < 4; i++){
+        raw[i] = all[i]->getReadingRaw(0);
+      }
+    });
+    printResult("4 chips sequential", seq);
+    BenchResult arr = measure(calls, 4, [&]{ array.readRaw(0, raw); });
+    printResult("4 chips AD7794Array", arr);
+    sinkRaw = raw[3];
+    bool rawOk = true;
+    for(uint8_t i = 0; i < 4; i++){
+      rawOk = rawOk && near(all[i]->rawToVolts(0, raw[i]), i == 0 ? 0.001 : 0);
+    }
+    check(rawOk, "AD7794Array readings do not match the inputs");
+    check(arr.elapsedNs < seq.elapsedNs, "AD7794Array no faster than reading the chips in turn");
+  }
+
+  //Compile-time configured driver on the same chip, six channels
+  {
+    typedef AD7794T<BENCH_CS, AD7794_Setup<AD7794_rateCode(470)>,
+                    AD7794_Ch<0, 128>, AD7794_Ch<1, 128>, AD7794_Ch<2, 128>,
+                    AD7794_Ch<3, 128>, AD7794_Ch<4, 128>, AD7794_Ch<5, 128> > Fixed6;
+    uint32_t raw[6];
+    int32_t uv[6];
+
+    Fixed6::begin();
+    printResult("AD7794T readAllRaw", measure(calls, 6, [&]{ Fixed6::readAllRaw(raw); }));
+    Fixed6::readAllFixed(uv);
+    printf("  last pass (uV) %.2f %.2f %.2f %.2f %.2f %.2f, sizeof AD7794T %u vs AD7794 %u bytes\n",
+           uv[0] / 256.0, uv[1] / 256.0, uv[2] / 256.0, uv[3] / 256.0, uv[4] / 256.0, uv[5] / 256.0,
+           (unsigned)sizeof(Fixed6), (unsigned)sizeof(AD7794));
+    bool uvOk = true;
+    for(uint8_t ch = 0; ch < 6; ch++){
+      uvOk = uvOk && fabs(uv[ch] / 256.0 - 1000.0 * (ch + 1)) < 0.1;
+    }
+    check(uvOk, "AD7794T readAllFixed() does not match the inputs");
+    adc.begin(); //The template left the chip in its own state, start over
+    adc.setUpdateRate(rate);
+  }
+
+  //A chip that never answers, with MISO pulled high (nothing on CS 20) and
+  //stuck low (CS 21): how long until the error. Stuck low looks like a
+  //finished channel 0 result, so channel 1 is read and every result is
+  //rejected as the wrong channel until the retries run out.
+  {
+    digitalWrite(21, HIGH);
+    StuckLowDevice low(21);
+    const uint8_t pins[2] = {20, 21};
+    for(uint8_t i = 0; i < 2; i++){
+      AD7794 stuck(pins[i], 4000000, 2.50);
+      const char *what = i ? "stuck low" : "stuck high";
+      char msg[64];
+      uint32_t raw = 0;
+      stuck.begin();
+      stuck.setUpdateRate(rate);
+      BenchResult r = measure(1, 1, [&]{ raw = stuck.getReadingRaw(1); });
+      printf("  %s: getReadingRaw(1) = 0x%08X after %.2f ms, %u status reads, %u rejected, timeout %u ms\n",
+             what, raw, r.elapsedNs / 1e6, stuck.getStatusReads(), stuck.getRejectedCount(), stuck.getTimeout());
+      snprintf(msg, sizeof(msg), "%s chip not reported as a timeout", what);
+      check(raw == AD7794_READ_ERROR && stuck.getLastError() == AD7794_Err_Timeout &&
+            r.elapsedNs < (AD7794_REJECT_RETRIES + 2) * 1e6 * stuck.getTimeout(), msg);
+
+      //The scan paths give up the same way, with nothing written past the error
+      uint32_t scan[2] = {1, 2};
+      stuck.setEnabled(1, true);
+      stuck.setMode(AD7794_OpMode_Continuous);
+      snprintf(msg, sizeof(msg), "readScan() on a %s chip", what);
+      check(stuck.readScan(scan, 2) == 0 && scan[0] == 1 && scan[1] == 2, msg);
+      stuck.setMode(AD7794_OpMode_SingleConv);
+      snprintf(msg, sizeof(msg), "scanEvery() on a %s chip", what);
+      check(!stuck.scanEvery(0, scan, 2) && stuck.getLastError() == AD7794_Err_Timeout, msg);
+    }
+  }
+
+  //Six K type thermocouples at 100..600 C with the junction at 25 C:
+  //cold junction read before every reading vs once every 16 readings
+  {
+    AD7794_Thermocouple tc(adc);
+    float degC[6];
+
+    sim.setTemperature(25.0);
+    for(uint8_t ch = 0; ch < 6; ch++){
+      adc.setGain(ch, 32);
+      sim.setInput(ch, (AD7794_tcDegCToMv(AD7794_TC_K, 100.0 * (ch + 1)) -
+                        AD7794_tcDegCToMv(AD7794_TC_K, 25.0)) / 1000.0);
+    }
+
+    auto readAll = [&]{
+      for(uint8_t ch = 0; ch < 6; ch++){
+        degC[ch] = tc.read(ch, AD7794_TC_K);
+      }
+    };
+
+    printf("\n%-24s %8s %10s %12s\n", "thermocouple (6 x K)", "samples", "bytes/smp", "us/smp");
+    uint16_t intervals[] = {1, 16};
+    for(uint8_t i = 0; i < 2; i++){
+      char name[32];
+      tc.setCjcInterval(intervals[i]);
+      BenchResult r = measure(calls / 6 + 1, 6, readAll);
+      snprintf(name, sizeof(name), "CJC every %u", intervals[i]);
+      printf("%-24s %8u %10.1f %12.1f\n", name, r.samples, r.bus.bytes / (double)r.samples,
+             r.elapsedNs / (double)r.samples / 1000.0);
+    }
+
+    double maxErr = 0;
+    for(uint8_t ch = 0; ch < 6; ch++){
+      double err = fabs(degC[ch] - 100.0 * (ch + 1));
+      if(err > maxErr) maxErr = err;
+    }
+    double maxFit = 0;
+    for(double t = -200; t <= 1372; t += 0.25){
+      double err = fabs(AD7794_tcMvToDegC(AD7794_TC_K, AD7794_tcDegCToMv(AD7794_TC_K, t)) - t);
+      if(err > maxFit) maxFit = err;
+    }
+    printf("  CJC %.2f C, last pass %.2f .. %.2f C, max error %.3f C (polynomial round trip %.3f C)\n",
+           tc.getCjcTemp(), degC[0], degC[5], maxErr, maxFit);
+    check(fabs(tc.getCjcTemp() - 25.0) < 0.1 && maxErr < 0.5 && maxFit < 0.1, "thermocouple temperatures off");
+
+    //A sensor correction shows straight away, without another junction read
+    tc.setCjcInterval(0);
+    tc.setCjcOffset(2.0);
+    double withOffset = tc.getCjcTemp();
+    tc.setCjcOffset(0);
+    check(fabs(withOffset - 27.0) < 0.1 && fabs(tc.getCjcTemp() - 25.0) < 0.1, "setCjcOffset() not applied at once");
+
+    for(uint8_t ch = 0; ch < 6; ch++){
+      adc.setGain(ch, 128);
+      sim.setInput(ch, 0.001 * (ch + 1));
+    }
+  }
+
+  //Mixed scan: channels 0 and 2 are fast bridges (470 Hz), 1 and 3 are
+  //50/60 Hz rejecting thermocouples (16.7 Hz). One chip-wide rate has to
+  //run them all at 16.7 Hz; per-channel rates keep the bridges fast and the
+  //scan groups the channels so the mode register changes twice per pass.
+  {
+    uint32_t raw[6];
+    uint8_t slow[] = {1, 3};
+    double msPerPass[2];
+
+    for(uint8_t ch = 0; ch < 6; ch++){
+      adc.setEnabled(ch, ch < 4);
+    }
+    adc.setMode(AD7794_OpMode_Continuous);
+
+    printf("\n%-24s %8s %10s %10s %12s\n", "mixed scan (4 ch)", "passes", "bytes/pass", "cs/pass", "ms/pass");
+    for(uint8_t perChannel = 0; perChannel < 2; perChannel++){
+      adc.setUpdateRate(perChannel ? 470 : 16.7);
+      if(perChannel){
+        for(uint8_t i = 0; i < 2; i++){
+          adc.setUpdateRate(slow[i], 16.7);
+        }
+      }
+      uint32_t passes = calls / 40 + 2;
+      adc.readScan(raw, 6); //Settle into the scan
+      BenchResult r = measure(passes, 1, [&]{ adc.readScan(raw, 6); });
+      printf("%-24s %8u %10.1f %10.1f %12.1f\n", perChannel ? "per-channel rate" : "chip-wide 16.7 Hz",
+             r.samples, r.bus.bytes / (double)r.samples, r.bus.csToggles / (double)r.samples,
+             r.elapsedNs / (double)r.samples / 1e6);
+      printf("  getScanRate() %.2f Hz, ch0 %.1f Hz, ch1 %.1f Hz\n", adc.getScanRate(),
+             adc.getUpdateRate(0), adc.getUpdateRate(1));
+      adc.stopScan();
+      msPerPass[perChannel] = r.elapsedNs / (double)r.samples / 1e6;
+      bool rawOk = true;
+      for(uint8_t ch = 0; ch < 4; ch++){
+        rawOk = rawOk && near(adc.rawToVolts(ch, raw[ch]), 0.001 * (ch + 1));
+      }
+      check(rawOk, "mixed scan readings do not match the inputs");
+    }
+    check(msPerPass[1] < msPerPass[0], "per-channel rates no faster than one chip-wide rate");
+
+    adc.setMode(AD7794_OpMode_SingleConv);
+    adc.setUpdateRate(rate);
+    for(uint8_t ch = 0; ch < 6; ch++){
+      adc.setEnabled(ch, true);
+    }
+  }
+
+  //Integrity: every 50 samples a glitch on DIN loses the conf write that
+  //selects the next scan channel, so the chip keeps converting the old one.
+  //The channel bits of the status byte catch the result before it is read
+  //and the channel is selected again. Channel 5 is driven over range.
+  {
+    AD7794_Sample s;
+    uint32_t got = 0, drops = 0, wrong = 0, flagged = 0;
+    uint32_t rejected = adc.getRejectedCount();
+
+    adc.setMode(AD7794_OpMode_Continuous);
+    sim.setInput(5, 0.05);
+    adc.startScan();
+    uint64_t t0 = HostSim::nowNs();
+    while(got < calls){
+      if(!adc.pollScan(s)){
+        continue;
+      }
+      got++;
+      if(got % 50 == 0 && got < calls){
+        sim.dropWrites(1);
+        drops++;
+      }
+      if(s.flags & AD7794_FLAG_RANGE){
+        flagged++;
+      }
+      if(s.channel < 5 && fabs(adc.rawToVolts(s.channel, s.raw) - 0.001 * (s.channel + 1)) > 0.0005){
+        wrong++;
+      }
+    }
+    uint64_t elapsed = HostSim::nowNs() - t0;
+    adc.stopScan();
+    adc.getLastError();
+
+    printf("\n%-24s %8s %8s %8s %10s %8s %10s\n", "integrity (6 ch scan)", "samples", "glitches",
+           "rejected", "mislabeled", "range", "us/smp");
+    rejected = adc.getRejectedCount() - rejected;
+    printf("%-24s %8u %8u %8u %10u %8u %10.1f\n", "status channel check", got, drops,
+           rejected, wrong, flagged, elapsed / (double)got / 1e3);
+    check(wrong == 0, "scan results labeled with the wrong channel");
+    check(rejected >= drops, "lost channel selects not caught by the status check");
+    check(flagged > 0, "over range channel not flagged");
+
+    sim.setInput(5, 0.006);
+    adc.setMode(AD7794_OpMode_SingleConv);
+  }
+
+  //Auto-range: channel 0 follows its input from gain 1 up to 128, channel 1
+  //sits at gain 1 on the same input. The simulated noise is in codes, so the
+  //higher gain shows up as lower input referred noise. Gain changes ride on
+  //the channel switch the scan makes anyway, so a settled pass costs the
+  //same bytes as one at a fixed gain.
+  {
+    const double levels[] = {2.0, 0.5, 0.1, 0.02, 0.004, 0.0008, 0.0002, 1.0};
+    uint32_t raw[6];
+
+    adc.setMode(AD7794_OpMode_Continuous);
+    for(uint8_t ch = 0; ch < 6; ch++){
+      adc.setEnabled(ch, ch < 2);
+    }
+    adc.setGain(0, 1);
+    adc.setGain(1, 1);
+    adc.setAutoRange(0, true);
+
+    printf("\n%-24s %6s %8s %10s %12s %12s\n", "auto-range (2 ch scan)", "gain", "passes",
+           "bytes/pass", "uV rms auto", "uV rms g1");
+    for(uint8_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++){
+      sim.setInput(0, levels[i]);
+      sim.setInput(1, levels[i]);
+
+      //Passes until the gain has stopped moving for 8 passes
+      uint32_t passes = 0, lastChange = 0;
+      uint8_t gain = adc.getGain(0);
+      while(passes - lastChange < 8){
+        adc.readScan(raw, 6);
+        passes++;
+        if(adc.getGain(0) != gain){
+          gain = adc.getGain(0);
+          lastChange = passes;
+        }
+      }
+
+      double sq0 = 0, sq1 = 0;
+      const uint32_t n = 32;
+      BenchResult r = measure(n, 1, [&]{
+        adc.readScan(raw, 6);
+        double e0 = (adc.rawToVolts(0, raw[0]) - levels[i]) * 1e6;
+        double e1 = (adc.rawToVolts(1, raw[1]) - levels[i]) * 1e6;
+        sq0 += e0 * e0;
+        sq1 += e1 * e1;
+      });
+      char name[24];
+      snprintf(name, sizeof(name), "%.4f V", levels[i]);
+      printf("%-24s %6u %8u %10.1f %12.3f %12.3f\n", name, adc.getGain(0), lastChange,
+             r.bus.bytes / (double)n, sqrt(sq0 / n), sqrt(sq1 / n));
+
+      //Settled between the thresholds, in 1/256 of full scale (one step of slack)
+      double level = levels[i] * adc.getGain(0) / 2.5 * 256;
+      check(level < AD7794_AUTORANGE_DOWN + 1 && (level > AD7794_AUTORANGE_UP - 1 || adc.getGain(0) == 128) &&
+            sqrt(sq0 / n) < 2.0, "auto-range settled on the wrong gain");
+    }
+    adc.stopScan();
+
+    adc.setAutoRange(0, false);
+    adc.setMode(AD7794_OpMode_SingleConv);
+    for(uint8_t ch = 0; ch < 6; ch++){
+      adc.setGain(ch, 128);
+      adc.setEnabled(ch, true);
+      sim.setInput(ch, 0.001 * (ch + 1));
+    }
+  }
+
+  //Burst: 16 results of channel 2 averaged, as 16 read() calls in single
+  //conversion mode (each a mode write and a full settling time) vs one
+  //readBurst() that selects the channel once and converts back to back.
+  //The simulated noise is 2 LSB rms, which the standard deviation shows.
+  {
+    const uint16_t n = 16;
+    const uint32_t bursts = calls / 40 + 2;
+    const char *names[] = {"readBurst mean", "readBurst trimmed", "readBurst median"};
+    AD7794_BurstResult res;
+    double v = 0;
+    bool ok = true;
+
+    printf("\n%-24s %8s %10s %10s %12s %12s\n", "burst (ch2, n=16)", "bursts", "bytes", "cs edges",
+           "ms/burst", "error uV");
+    BenchResult r = measure(bursts, 1, [&]{
+      double s = 0;
+      for(uint16_t i = 0; i < n; i++){
+        s += adc.read(2);
+      }
+      v = s / n;
+    });
+    printf("%-24s %8u %10.1f %10.1f %12.2f %12.4f\n", "16 x read()", r.samples,
+           r.bus.bytes / (double)r.samples, r.bus.csToggles / (double)r.samples, r.elapsedNs / (double)r.samples / 1e6, (v - 0.003) * 1e6);
+    BenchResult single = r;
+
+    for(uint8_t mode = 0; mode < 3; mode++){
+      r = measure(bursts, 1, [&]{ ok = adc.readBurst(2, n, (AD7794_BurstMode)mode, res) && ok; });
+      printf("%-24s %8u %10.1f %10.1f %12.2f %12.4f\n", names[mode], r.samples,
+             r.bus.bytes / (double)r.samples, r.bus.csToggles / (double)r.samples, r.elapsedNs / (double)r.samples / 1e6,
+             (adc.rawToVolts(2, res.raw) - 0.003) * 1e6);
+      ok = ok && res.count == n && near(adc.rawToVolts(2, res.raw), 0.003) &&
+           r.bus.bytes < single.bus.bytes && r.bus.csToggles < single.bus.csToggles && r.elapsedNs < single.elapsedNs;
+    }
+    printf("  %u results, std dev %.2f LSB, peak to peak %u LSB\n", res.count, res.stdDev, res.peakToPeak);
+    check(near(v, 0.003), "16 x read() average off the input");
+    check(ok, "readBurst() failed, off the input or no cheaper than 16 x read()");
+    check(!adc.readBurst(2, AD7794_BURST_MAX + 1, AD7794_Burst_Median, res), "readBurst() accepted n > AD7794_BURST_MAX");
+  }
+
+  //Duty cycle: a logger scans 6 channels once a second. Waking with begin()
+  //(reset, delay, throw-away read) and read(buf,6) vs scanEvery(), which
+  //powers the chip down between scans and wakes it with the first
+  //conversion's register writes. Charge uses the sim's powered time at the
+  //in-amp current (all channels at gain 128); scanEvery() also has its own
+  //estimate.
+  {
+    uint32_t raw[6];
+    float out[6];
+    const uint8_t cycles = 5;
+
+    printf("\n%-24s %10s %12s %10s %10s %10s %8s\n", "duty cycle (6 ch, 1 s)", "1st smp us",
+           "scan ms", "awake ms", "charge uC", "est uC", "avg uA");
+
+    uint64_t p0 = sim.poweredNs();
+    uint64_t t0 = HostSim::nowNs();
+    adc.begin();
+    uint64_t first = HostSim::nowNs() - t0;
+    adc.read(out, 6);
+    uint64_t scan = HostSim::nowNs() - t0;
+    double awake = (sim.poweredNs() - p0) / 1e6;
+    double awakeBegin = awake;
+    printf("%-24s %10.0f %12.2f %10.2f %10.2f %10s %8.1f\n", "begin() + read(buf,6)", first / 1e3,
+           scan / 1e6, awake, awake * AD7794_IDD_INAMP_UA / 1e3, "-",
+           awake * AD7794_IDD_INAMP_UA / 1e3 + (1000 - awake) / 1000 * AD7794_IDD_PD_UA);
+
+    double latency = 0, est = 0;
+    scan = 0;
+    adc.scanEvery(1000, raw, 6); //Starts the schedule
+    p0 = sim.poweredNs();
+    for(uint8_t i = 0; i < cycles; i++){
+      while((t0 = HostSim::nowNs()), !adc.scanEvery(1000, raw, 6)){
+        delay(1);
+      }
+      scan += HostSim::nowNs() - t0;
+      latency += adc.getWakeLatency();
+      est += adc.getScanCharge();
+    }
+    awake = (sim.poweredNs() - p0) / 1e6 / cycles;
+    printf("%-24s %10.0f %12.2f %10.2f %10.2f %10.2f %8.1f\n", "scanEvery(1000)", latency / cycles,
+           scan / 1e6 / cycles, awake, awake * AD7794_IDD_INAMP_UA / 1e3, est / cycles,
+           awake * AD7794_IDD_INAMP_UA / 1e3 + (1000 - awake) / 1000 * AD7794_IDD_PD_UA);
+    printf("%-24s %10s %12s %10.2f %10.2f %10s %8.1f\n", "always converting", "-", "-", 1000.0,
+           1000.0 * AD7794_IDD_INAMP_UA / 1e3, "-", (double)AD7794_IDD_INAMP_UA);
+    printf("  last scan ch0 %.4f V, chip powered down: %s\n", adc.rawToVolts(0, raw[0]),
+           (sim.modeReg() >> 13) == 3 ? "yes" : "no");
+    double charge = awake * AD7794_IDD_INAMP_UA / 1e3;
+    check(near(adc.rawToVolts(0, raw[0]), 0.001), "scanEvery() reading does not match the input");
+    check((sim.modeReg() >> 13) == 3, "chip not powered down between scans");
+    check(awake < awakeBegin, "scanEvery() awake no shorter than begin() + read(buf,6)");
+    check(fabs(est / cycles - charge) < 0.2 * charge, "getScanCharge() estimate off the powered time");
+  }
+
+  //Two chips sharing SPI behind one bus lock, from two threads: an
+  //acquisition task scans three channels of the first into a broadcast
+  //ring read by three consumer threads (one slowed down on purpose), while
+  //a second thread reads the other chip directly. Half way through another
+  //thread halves the scan's update rate with call(). Every sample is checked
+  //against the simulated input. The virtual clock is shared, so the delays
+  //of both driver threads add up and the rates are lower bounds; what the
+  //slow reader loses depends on the host's scheduler.
+  {
+    const uint8_t csA = 15, csB = 16;
+    digitalWrite(csA, HIGH);
+    digitalWrite(csB, HIGH);
+    AD7794Sim simA(csA), simB(csB);
+    AD7794_SPITransport spiPort;
+    HostBusLock busLock;
+    AD7794_LockedTransport locked(spiPort, busLock);
+    AD7794 adcA(csA, 4000000, 2.50, locked);
+    AD7794 adcB(csB, 4000000, 2.50, locked);
+    static AD7794_BroadcastRing<16> ring;
+    AD7794_Acquisition acq(adcA, ring);
+    const uint32_t target = 2 * calls;
+
+    adcA.begin();
+    adcB.begin();
+    adcA.setUpdateRate(rate);
+    adcB.setUpdateRate(rate);
+    for(uint8_t ch = 0; ch < 3; ch++){
+      simA.setInput(ch, 0.1 * (ch + 1));
+      adcA.setEnabled(ch, true);
+    }
+    simB.setInput(0, 1.25);
+    adcB.setEnabled(0, true);
+    uint32_t expectA[3];
+    for(uint8_t ch = 0; ch < 3; ch++){
+      expectA[ch] = (uint32_t)(0.1 * (ch + 1) / 2.5 * 0x800000) + 0x800000;
+    }
+
+    std::atomic<bool> done(false);
+    struct Consumer { uint32_t got = 0, bad = 0; uint32_t lost = 0; };
+    Consumer consumers[3];
+    std::vector<std::thread> threads;
+    for(uint8_t i = 0; i < 3; i++){
+      threads.emplace_back([&, i]{
+        AD7794_BroadcastReader reader(ring);
+        AD7794_Sample s;
+        while(!done.load()){
+          if(!reader.read(s)){
+            std::this_thread::yield();
+            continue;
+          }
+          consumers[i].got++;
+          int32_t diff = (int32_t)s.raw - (int32_t)expectA[s.channel < 3 ? s.channel : 0];
+          if(s.channel >= 3 || diff > 4 || diff < -4) consumers[i].bad++;
+          if(i == 2) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        consumers[i].lost = reader.lost();
+      });
+    }
+
+    uint32_t readsB = 0, badB = 0;
+    threads.emplace_back([&]{
+      while(!done.load()){
+        uint32_t raw = adcB.getReadingRaw(0);
+        readsB++;
+        int32_t diff = (int32_t)raw - (int32_t)(0x800000 + 0x400000);
+        if(diff > 4 || diff < -4) badB++;
+      }
+    });
+
+    uint64_t t0 = HostSim::nowNs();
+    uint32_t c0 = simA.conversionCount();
+    acq.markRunning();
+    std::thread task([&]{ acq.run(); });
+    while(ring.published() < target / 2) std::this_thread::yield();
+    double halfRate = rate / 2;
+    bool called = acq.call([](AD7794 &a, void *arg){ a.setUpdateRate(*(double *)arg); }, &halfRate);
+    while(ring.published() < target) std::this_thread::yield();
+    acq.stop();
+    task.join();
+    done.store(true);
+    for(std::thread &t : threads) t.join();
+    double secs = (HostSim::nowNs() - t0) / 1e9;
+
+    printf("\n%-24s %8s %8s %8s %10s\n", "shared bus (threads)", "samples", "lost", "bad", "smp/s");
+    printf("%-24s %8u %8s %8s %10.1f\n", "acquisition (3 ch)", ring.published(), "-", "-",
+           ring.published() / secs);
+    for(uint8_t i = 0; i < 3; i++){
+      char name[32];
+      snprintf(name, sizeof(name), "reader %u%s", i, i == 2 ? " (slow)" : "");
+      printf("%-24s %8u %8u %8u %10s\n", name, consumers[i].got, consumers[i].lost, consumers[i].bad, "-");
+    }
+    printf("%-24s %8u %8s %8u %10.1f\n", "getReadingRaw(0) chip 2", readsB, "-", badB, readsB / secs);
+    printf("  %u lock waits, %u conversions on chip 1, update rate after call() %.2f Hz (sim %.2f Hz)\n",
+           busLock.contended(), simA.conversionCount() - c0, adcA.getUpdateRate(0), simA.updateRateHz());
+    bool readersOk = true;
+    for(uint8_t i = 0; i < 3; i++){
+      readersOk = readersOk && consumers[i].got > 0 && consumers[i].bad == 0;
+    }
+    check(readersOk, "broadcast readers got wrong samples");
+    check(readsB > 0 && badB == 0, "second chip on the locked bus read wrong");
+    check(called && fabs(adcA.getUpdateRate(0) - simA.updateRateHz()) < 0.1, "call() did not change the update rate");
+  }
+
+  //A chip on its own SPIClass instance through the mock transport, with
+  //1 us of CPU charged per call into the transport: every register access
+  //as one bulk transfer vs split into single byte calls
+  {
+    const uint8_t cs = 14;
+    digitalWrite(cs, HIGH);
+    AD7794Sim simT(cs);
+    SPIClass spi1;
+    MockTransport mock(spi1);
+    AD7794 adcT(cs, 4000000, 2.50, mock);
+    float out[6];
+    double callsPerSmp[2][2];
+
+    mock.setCallCostNs(1000);
+    adcT.begin();
+    adcT.setUpdateRate(rate);
+    for(uint8_t ch = 0; ch < 6; ch++){
+      adcT.setGain(ch, 128);
+      adcT.setEnabled(ch, true);
+    }
+
+    mock.setTrace(true);
+    adcT.getReadingRaw(1);
+    const std::vector<uint8_t> &t = mock.trace();
+    bool traceOk = t.size() >= 6 && t[0] == AD7794_WRITE_CONF_REG && t[3] == AD7794_WRITE_MODE_REG;
+    mock.setTrace(false);
+
+    printf("\n%-24s %10s %10s %12s\n", "transport (1 us/call)", "calls/smp", "bytes/smp", "us/smp");
+    for(uint8_t split = 0; split < 2; split++){
+      mock.setSplitBulk(split);
+      for(uint8_t cont = 0; cont < 2; cont++){
+        char name[40];
+        adcT.setMode(cont ? AD7794_OpMode_Continuous : AD7794_OpMode_SingleConv);
+        adcT.read(out, 6);
+        mock.resetStats();
+        BenchResult r = measure(calls / 6 + 1, 6, [&]{ adcT.read(out, 6); });
+        const MockTransportStats &s = mock.stats();
+        snprintf(name, sizeof(name), "%s %s", split ? "bytewise" : "bulk", cont ? "scan" : "read(buf,6)");
+        callsPerSmp[split][cont] = (s.byteCalls + s.bulkCalls + s.transactions) / (double)r.samples;
+        printf("%-24s %10.2f %10.2f %12.1f\n", name, callsPerSmp[split][cont],
+               s.bytes / (double)r.samples, r.elapsedNs / (double)r.samples / 1000.0);
+      }
+      adcT.setMode(AD7794_OpMode_SingleConv);
+    }
+    printf("  channel select + start as one transfer: %s, last %.6f V\n", traceOk ? "yes" : "no", out[5]);
+    check(traceOk, "channel select and start not one transfer");
+    check(near(out[5], 0), "transport reading does not match the input");
+    check(callsPerSmp[0][0] < callsPerSmp[1][0] && callsPerSmp[0][1] < callsPerSmp[1][1],
+          "bulk transfers no fewer calls than byte-wise");
+  }
+
+  //Six channel scan passes sent as binary frames vs text the way the
+  //examples print (Serial.print(v, DEC), a tab between channels), then
+  //decoded on the host with one byte corrupted in transit
+  {
+    const uint32_t passes = calls / 6 + 8;
+    std::vector<uint8_t> stream;
+    std::vector<float> expected;
+    uint32_t raw[6];
+    uint8_t frame[AD7794_FRAME_MAX_SIZE];
+    char text[32];
+    size_t textBytes = 0;
+    AD7794_FrameEncoder encoder(0x3F);
+
+    for(uint8_t ch = 0; ch < 6; ch++){
+      uint8_t n = encoder.encodeScale(frame, sizeof(frame), ch, adc.getScale(ch));
+      stream.insert(stream.end(), frame, frame + n);
+    }
+
+    adc.setMode(AD7794_OpMode_Continuous);
+    double encodeNs = 0, textNs = 0;
+    for(uint32_t p = 0; p < passes; p++){
+      adc.readScan(raw, 6);
+      uint32_t timestamp = micros();
+      auto t0 = std::chrono::steady_clock::now();
+      uint8_t n = encoder.encode(frame, sizeof(frame), raw, timestamp);
+      auto t1 = std::chrono::steady_clock::now();
+      for(uint8_t ch = 0; ch < 6; ch++){
+        float v = adc.rawToVolts(ch, raw[ch]);
+        textBytes += snprintf(text, sizeof(text), "%.10f\t", v);
+        expected.push_back(v);
+      }
+      textBytes += 2; //println
+      auto t2 = std::chrono::steady_clock::now();
+      encodeNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+      textNs += std::chrono::duration<double, std::nano>(t2 - t1).count();
+      stream.insert(stream.end(), frame, frame + n);
+    }
+    adc.stopScan();
+    adc.setMode(AD7794_OpMode_SingleConv);
+
+    stream[stream.size() / 2] ^= 0x10; //Damage one frame
+
+    AD7794FrameDecoder decoder;
+    AD7794Frame f;
+    size_t pos = 0, used;
+    double maxErr = 0;
+    while(pos < stream.size()){
+      if(decoder.feed(&stream[pos], stream.size() - pos, used, f)){
+        for(uint8_t i = 0; i < f.count; i++){
+          double err = fabs(f.volts[i] - expected[f.sequence * 6 + i]) * 1e6;
+          if(err > maxErr) maxErr = err;
+        }
+      }
+      pos += used;
+    }
+
+    double samples = passes * 6.0;
+    printf("\n%-24s %10s %12s\n", "streaming (6 ch)", "bytes/smp", "host ns/smp");
+    printf("%-24s %10.2f %12.1f\n", "binary frames", (stream.size() - 6 * AD7794_FRAME_SCALE_SIZE) / samples, encodeNs / samples);
+    printf("%-24s %10.2f %12.1f\n", "text, 10 decimals", textBytes / samples, textNs / samples);
+    printf("  decoded %u of %u frames, %u CRC errors, %u lost by sequence, max error %.4f uV\n",
+           decoder.frameCount(), passes, decoder.crcErrors(), decoder.lostFrames(), maxErr);
+    check(decoder.frameCount() == passes - 1 && decoder.crcErrors() == 1 && decoder.lostFrames() == 1,
+          "frame decoder did not drop exactly the damaged frame");
+    check(maxErr < 0.01, "decoded frames off the readings");
+    check(stream.size() - 6 * AD7794_FRAME_SCALE_SIZE < textBytes, "binary frames no smaller than text");
+  }
+
+  //On-chip calibration vs restoring stored coefficients after a cold boot.
+  //Channel 1 at gain 16 with 20 uV offset and +0.2% gain error in the front end.
+  {
+    const char *calFile = "/tmp/bench_ad7794_cal.bin";
+    FileCalStorage storage(calFile);
+    remove(calFile);
+
+    sim.setOffsetError(1, 20e-6);
+    sim.setGainError(1, 0.002);
+    adc.setGain(1, 16);
+    for(uint8_t ch = 0; ch < 6; ch++){
+      adc.setEnabled(ch, ch == 1);
+    }
+
+    auto errUv = [&]{ return (adc.read(1) - 0.002) * 1e6; };
+    double before = errUv();
+    BenchResult cal = measure(1, 1, [&]{ adc.calibrate(1); });
+    double afterCal = errUv();
+    adc.saveCalibration(storage);
+
+    adc.reset(); //Cold boot, registers back to power-on values
+    delay(1);
+    double afterReset = errUv();
+    BenchResult restore = measure(1, 1, [&]{ adc.restoreCalibration(storage); });
+    double afterRestore = errUv();
+
+    printf("\n%-24s %8s %10s %12s\n", "calibration (ch1, g16)", "bytes", "cs edges", "ms");
+    printf("%-24s %8llu %10llu %12.2f\n", "calibrate()", (unsigned long long)cal.bus.bytes,
+           (unsigned long long)cal.bus.csToggles, cal.elapsedNs / 1e6);
+    printf("%-24s %8llu %10llu %12.2f\n", "restoreCalibration()", (unsigned long long)restore.bus.bytes,
+           (unsigned long long)restore.bus.csToggles, restore.elapsedNs / 1e6);
+    printf("  error %.2f uV uncalibrated, %.2f uV calibrated, %.2f uV after reset, %.2f uV restored\n",
+           before, afterCal, afterReset, afterRestore);
+    check(fabs(before) > 10 && fabs(afterReset) > 10, "front end errors not visible uncalibrated");
+    check(fabs(afterCal) < 0.5, "calibrate() did not remove the error");
+    check(fabs(afterRestore - afterCal) < 0.5, "restoreCalibration() did not bring the calibration back");
+    check(restore.bus.bytes < cal.bus.bytes && restore.elapsedNs < cal.elapsedNs, "restoring no cheaper than calibrating");
+
+    sim.setOffsetError(1, 0);
+    sim.setGainError(1, 0);
+    adc.setGain(1, 128);
+    for(uint8_t ch = 0; ch < 6; ch++){
+      adc.setEnabled(ch, true);
+    }
+    remove(calFile);
+  }
+
+  printf("\n%-24s %8s %10s\n", "config", "bytes", "cs edges");
+  printf("%-24s %8llu %10llu\n", "6 ch x 4 setters", (unsigned long long)cfg.bus.bytes, (unsigned long long)cfg.bus.csToggles);
+  printf("%-24s %8llu %10llu\n", "  beginConfig/commit", (unsigned long long)cfgBatch.bus.bytes, (unsigned long long)cfgBatch.bus.csToggles);
+  printf("%-24s %8llu %10llu\n", "ch0 gain/buf/ref/rate", (unsigned long long)cfgCh0.bus.bytes, (unsigned long long)cfgCh0.bus.csToggles);
+  printf("%-24s %8llu %10llu\n", "  beginConfig/commit", (unsigned long long)cfgCh0Batch.bus.bytes, (unsigned long long)cfgCh0Batch.bus.csToggles);
+  printf("register writes skipped by the shadow cache: %u\n", adc.getSkippedWrites());
+  printf("status register reads while waiting: %u, timeouts: %u\n", adc.getStatusReads(), adc.getTimeoutCount());
+  check(cfgBatch.bus.bytes <= cfg.bus.bytes, "beginConfig/commit more bytes than direct setters");
+  check(cfgCh0Batch.bus.bytes < cfgCh0.bus.bytes && cfgCh0Batch.bus.csToggles < cfgCh0.bus.csToggles,
+        "beginConfig/commit no cheaper than direct setters on the selected channel");
+  check(adc.getTimeoutCount() == 0, "timeouts on a working chip");
+
+#ifdef AD7794_ENABLE_STATS
+  //Instrumented single channel reads at the current rate, then slow and chop off
+  auto statsRun = [&](const char *name){
+    adc.resetStats();
+    for(uint32_t i = 0; i < calls; i++){
+      sinkRaw = adc.getReadingRaw(0);
+    }
+    const AD7794_Stats &s = adc.getStats();
+    printf("%-24s %8u %10.2f %10.1f %10.1f %8u %8u %10u\n", name, s.samples,
+           (double)s.statusPolls / s.samples, (double)s.dataBytes / s.samples,
+           (double)s.configBytes / s.samples, s.confWrites, s.modeWrites, s.maxWaitUs);
+    printf("  ch0 wait histogram (ms: <1 1 2 4 8 16 32 64 128 256+):");
+    for(uint8_t b = 0; b < AD7794_STATS_BUCKETS; b++){
+      printf(" %u", s.waitHist[0][b]);
+    }
+    printf("\n");
+    check(s.samples == calls && s.statusPolls >= s.samples, "stats do not count every sample");
+  };
+
+  printf("\n%-24s %8s %10s %10s %10s %8s %8s %10s\n", "stats getReadingRaw(0)", "samples",
+         "polls/smp", "data B/smp", "cfg B/smp", "conf wr", "mode wr", "max wait");
+  statsRun("chop on");
+  adc.setChopEnabled(false);
+  statsRun("chop off");
+  adc.setChopEnabled(true);
+#endif
+
+  //Conversion cost on the host CPU (real time, not simulated), float
+  //rawToVolts() against the precomputed fixed point path
+  {
+    const uint32_t n = 4096;
+    const int reps = 200;
+    static uint32_t raw[n];
+    static float outF[n];
+    static int32_t outQ[n];
+    uint32_t seed = 1;
+
+    for(uint32_t i = 0; i < n; i++){
+      seed = seed * 1103515245 + 12345;
+      raw[i] = (seed >> 8) & 0xFFFFFF;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for(int r = 0; r < reps; r++){
+      for(uint32_t i = 0; i < n; i++){
+        outF[i] = adc.rawToVolts(0, raw[i]);
+      }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for(int r = 0; r < reps; r++){
+      adc.convert(0, raw, outQ, n);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double maxErr = 0;
+    for(uint32_t i = 0; i < n; i++){
+      double uv = outQ[i] / (double)(1 << AD7794_FIXED_FRAC_BITS);
+      double err = uv - outF[i] * 1e6;
+      if(err < 0) err = -err;
+      if(err > maxErr) maxErr = err;
+    }
+
+    double total = (double)n * reps;
+    printf("\n%-24s %10s\n", "scaling (host CPU)", "ns/smp");
+    printf("%-24s %10.2f\n", "rawToVolts (float)", std::chrono::duration<double, std::nano>(t1 - t0).count() / total);
+    printf("%-24s %10.2f\n", "convert (fixed point)", std::chrono::duration<double, std::nano>(t2 - t1).count() / total);
+    printf("  max difference %.4f uV (gain 128, 1 LSB = %.4f uV)\n", maxErr, 2.5e6 / 128 / 8388608);
+    check(maxErr < 2.0 / (1 << AD7794_FIXED_FRAC_BITS), "convert() off rawToVolts() by more than 2 fixed point steps");
+  }
+
+  (void)sinkRaw; (void)sinkF;
+  if(failures){
+    printf("\n%u checks failed\n", failures);
+  }
+  return failures > 125 ? 125 : failures;
+}
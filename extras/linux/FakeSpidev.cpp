@@ -0,0 +1,316 @@
+/*
+  FakeSpidev.cpp - Fake spidev and GPIO character devices, see
+  FakeSpidev.h.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#include <errno.h>
+#include <string.h>
+#include <linux/gpio.h>
+#include <linux/spi/spidev.h>
+#include <mutex>
+#include "FakeSpidev.h"
+#include "HostSim.h"
+#include "LinuxSys.h"
+
+#define FAKE_MAX_DEVICES    8
+#define FAKE_MAX_BINDINGS   8
+#define FAKE_MAX_FDS       32
+#define FAKE_FD_BASE     1000
+
+enum FakeKind { FakeFree = 0, FakeSpi, FakeChip, FakeLine };
+
+struct Binding
+{
+  const char *path;   //spidev node or gpiochip
+  uint32_t line;
+  uint8_t csPin;
+};
+
+struct FakeFd
+{
+  FakeKind kind;
+  const char *path;
+  uint8_t csPin;      //Device behind it, 0xFF for none
+  uint8_t mode;       //spidev SPI_IOC_WR_MODE
+  uint8_t level;      //GPIO line output
+};
+
+static std::recursive_mutex fakeMutex;
+static HostSpiDevice *devices[FAKE_MAX_DEVICES];
+static uint8_t deviceCount = 0;
+static Binding spiBindings[FAKE_MAX_BINDINGS];
+static uint8_t spiBindingCount = 0;
+static Binding gpioBindings[FAKE_MAX_BINDINGS];
+static uint8_t gpioBindingCount = 0;
+static FakeFd fds[FAKE_MAX_FDS];
+
+
+//////// Simulated devices /////////////////
+
+void HostSim::attach(HostSpiDevice *dev)
+{
+  std::lock_guard<std::recursive_mutex> lock(fakeMutex);
+  if(deviceCount < FAKE_MAX_DEVICES){
+    devices[deviceCount++] = dev;
+    dev->advanceTo(LinuxSys::nowNs());
+  }
+}
+
+void HostSim::detach(HostSpiDevice *dev)
+{
+  std::lock_guard<std::recursive_mutex> lock(fakeMutex);
+  for(uint8_t i = 0; i < deviceCount; i++){
+    if(devices[i] == dev){
+      devices[i] = devices[--deviceCount];
+      return;
+    }
+  }
+}
+
+static HostSpiDevice *deviceFor(uint8_t csPin)
+{
+  uint64_t now = LinuxSys::nowNs();
+  for(uint8_t i = 0; i < deviceCount; i++){
+    devices[i]->advanceTo(now);
+  }
+  for(uint8_t i = 0; i < deviceCount; i++){
+    if(devices[i]->csPin() == csPin){
+      return devices[i];
+    }
+  }
+  return nullptr;
+}
+
+//Device currently selected by a GPIO line held low
+static HostSpiDevice *gpioSelected()
+{
+  for(uint8_t i = 0; i < FAKE_MAX_FDS; i++){
+    if(fds[i].kind == FakeLine && fds[i].csPin != 0xFF && fds[i].level == 0){
+      return deviceFor(fds[i].csPin);
+    }
+  }
+  return nullptr;
+}
+
+
+//////// Calls /////////////////
+
+static FakeFd *lookup(int fd)
+{
+  int i = fd - FAKE_FD_BASE;
+  if(i < 0 || i >= FAKE_MAX_FDS || fds[i].kind == FakeFree){
+    return nullptr;
+  }
+  return &fds[i];
+}
+
+static int allocate(FakeKind kind, const char *path, uint8_t csPin)
+{
+  for(int i = 0; i < FAKE_MAX_FDS; i++){
+    if(fds[i].kind == FakeFree){
+      fds[i].kind = kind;
+      fds[i].path = path;
+      fds[i].csPin = csPin;
+      fds[i].mode = 0;
+      fds[i].level = 1;
+      return FAKE_FD_BASE + i;
+    }
+  }
+  errno = EMFILE;
+  return -1;
+}
+
+static int fakeOpen(const char *path, int flags)
+{
+  (void)flags;
+  std::lock_guard<std::recursive_mutex> lock(fakeMutex);
+  for(uint8_t i = 0; i < spiBindingCount; i++){
+    if(strcmp(spiBindings[i].path, path) == 0){
+      return allocate(FakeSpi, spiBindings[i].path, spiBindings[i].csPin);
+    }
+  }
+  if(strncmp(path, "/dev/spidev", 11) == 0){
+    return allocate(FakeSpi, path, 0xFF); //Nothing behind it unless CS comes from a GPIO
+  }
+  if(strncmp(path, "/dev/gpiochip", 13) == 0){
+    return allocate(FakeChip, path, 0xFF);
+  }
+  errno = ENOENT;
+  return -1;
+}
+
+static int fakeClose(int fd)
+{
+  std::lock_guard<std::recursive_mutex> lock(fakeMutex);
+  FakeFd *f = lookup(fd);
+  if(f == nullptr){
+    errno = EBADF;
+    return -1;
+  }
+  f->kind = FakeFree;
+  return 0;
+}
+
+static int spiMessage(FakeFd *f, struct spi_ioc_transfer *xfers, unsigned n)
+{
+  bool ownCs = !(f->mode & SPI_NO_CS);
+  HostSpiDevice *dev = ownCs ? deviceFor(f->csPin) : gpioSelected();
+  int total = 0;
+
+  if(ownCs && dev != nullptr){
+    dev->select(true);
+  }
+  for(unsigned i = 0; i < n; i++){
+    const uint8_t *tx = (const uint8_t *)(uintptr_t)xfers[i].tx_buf;
+    uint8_t *rx = (uint8_t *)(uintptr_t)xfers[i].rx_buf;
+    for(uint32_t b = 0; b < xfers[i].len; b++){
+      uint8_t out = tx != nullptr ? tx[b] : 0;
+      uint8_t in = 0xFF;
+      if(dev != nullptr){
+        dev->advanceTo(LinuxSys::nowNs());
+        in = dev->exchange(out);
+      }
+      if(rx != nullptr){
+        rx[b] = in;
+      }
+    }
+    total += xfers[i].len;
+    if(ownCs && dev != nullptr && xfers[i].cs_change && i + 1 < n){
+      dev->select(false);
+      dev->select(true);
+    }
+  }
+  if(ownCs && dev != nullptr && !(n > 0 && xfers[n - 1].cs_change)){
+    dev->select(false);
+  }
+  return total;
+}
+
+static int lineRequest(FakeFd *chip, struct gpio_v2_line_request *req)
+{
+  uint8_t csPin = 0xFF;
+  for(uint8_t i = 0; i < gpioBindingCount; i++){
+    if(strcmp(gpioBindings[i].path, chip->path) == 0 && gpioBindings[i].line == req->offsets[0]){
+      csPin = gpioBindings[i].csPin;
+    }
+  }
+  int fd = allocate(FakeLine, chip->path, csPin);
+  if(fd < 0){
+    return -1;
+  }
+  FakeFd *line = lookup(fd);
+  for(uint32_t i = 0; i < req->config.num_attrs; i++){
+    if(req->config.attrs[i].attr.id == GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES){
+      line->level = req->config.attrs[i].attr.values & 1;
+    }
+  }
+  HostSpiDevice *dev = (csPin != 0xFF) ? deviceFor(csPin) : nullptr;
+  if(dev != nullptr){
+    dev->select(line->level == 0);
+  }
+  req->fd = fd;
+  return 0;
+}
+
+static int fakeIoctl(int fd, unsigned long request, void *arg)
+{
+  std::lock_guard<std::recursive_mutex> lock(fakeMutex);
+  FakeFd *f = lookup(fd);
+  if(f == nullptr){
+    errno = EBADF;
+    return -1;
+  }
+
+  switch(f->kind){
+    case FakeSpi:
+      if(_IOC_TYPE(request) == SPI_IOC_MAGIC && _IOC_NR(request) == 0 && _IOC_DIR(request) == _IOC_WRITE){
+        return spiMessage(f, (struct spi_ioc_transfer *)arg, _IOC_SIZE(request) / sizeof(struct spi_ioc_transfer));
+      }
+      if(request == SPI_IOC_WR_MODE){
+        f->mode = *(uint8_t *)arg;
+        return 0;
+      }
+      if(request == SPI_IOC_WR_BITS_PER_WORD || request == SPI_IOC_WR_MAX_SPEED_HZ){
+        return 0;
+      }
+      break;
+
+    case FakeChip:
+      if(request == GPIO_V2_GET_LINE_IOCTL){
+        return lineRequest(f, (struct gpio_v2_line_request *)arg);
+      }
+      break;
+
+    case FakeLine:
+    {
+      struct gpio_v2_line_values *v = (struct gpio_v2_line_values *)arg;
+      HostSpiDevice *dev = (f->csPin != 0xFF) ? deviceFor(f->csPin) : nullptr;
+      if(request == GPIO_V2_LINE_SET_VALUES_IOCTL){
+        if(v->mask & 1){
+          f->level = v->bits & 1;
+          if(dev != nullptr){
+            dev->select(f->level == 0);
+          }
+        }
+        return 0;
+      }
+      if(request == GPIO_V2_LINE_GET_VALUES_IOCTL){
+        v->bits = f->level;
+        return 0;
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+  errno = ENOTTY;
+  return -1;
+}
+
+static const LinuxSysOps fakeOps = { fakeOpen, fakeClose, fakeIoctl };
+
+void FakeSpidev::install()
+{
+  LinuxSys::setOps(&fakeOps);
+}
+
+void FakeSpidev::uninstall()
+{
+  LinuxSys::setOps(nullptr);
+}
+
+void FakeSpidev::bindSpidev(const char *path, uint8_t csPin)
+{
+  std::lock_guard<std::recursive_mutex> lock(fakeMutex);
+  if(spiBindingCount < FAKE_MAX_BINDINGS){
+    spiBindings[spiBindingCount++] = {path, 0, csPin};
+  }
+}
+
+void FakeSpidev::bindGpio(const char *chip, uint32_t line, uint8_t csPin)
+{
+  std::lock_guard<std::recursive_mutex> lock(fakeMutex);
+  if(gpioBindingCount < FAKE_MAX_BINDINGS){
+    gpioBindings[gpioBindingCount++] = {chip, line, csPin};
+  }
+}
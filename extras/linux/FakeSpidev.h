@@ -0,0 +1,46 @@
+/*
+  FakeSpidev.h - A LinuxSysOps table that stands in for /dev/spidev and
+  /dev/gpiochip nodes, routing SPI messages and CS lines to simulated SPI
+  devices (extras/host/AD7794Sim), so the Linux backend runs on any Linux
+  box. The simulated devices run on the real monotonic clock.
+
+  Provides HostSim::attach()/detach(), which the simulated devices call,
+  so link it instead of extras/host/HostArduino.cpp.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#ifndef FAKE_SPIDEV_h
+#define FAKE_SPIDEV_h
+
+#include <stdint.h>
+
+namespace FakeSpidev
+{
+  void install();     //LinuxSys calls go to the fakes from here on
+  void uninstall();
+
+  //The simulated device, by its CS pin, that answers on a spidev node when
+  //spidev drives CS, or that a GPIO line selects
+  void bindSpidev(const char *path, uint8_t csPin);
+  void bindGpio(const char *chip, uint32_t line, uint8_t csPin);
+}
+
+#endif
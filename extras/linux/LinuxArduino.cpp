@@ -0,0 +1,176 @@
+/*
+  LinuxArduino.cpp - The Arduino functions the driver uses, on Linux:
+  millis()/micros() from CLOCK_MONOTONIC, delays with clock_nanosleep(),
+  pins on GPIO character device lines (see LinuxGpio::mapPin()). Builds
+  against the stand-in Arduino.h and SPI.h in extras/host. Interrupts are
+  not available, so neither is the DRDY interrupt streaming.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <errno.h>
+#include <time.h>
+#include "LinuxGpio.h"
+#include "LinuxSys.h"
+
+#define LINUX_MAX_PINS   64
+#define LINUX_YIELD_NS   50000   //yield() sleeps rather than spins, the driver calls it in waits
+
+SPIClass SPI;
+
+struct PinMap
+{
+  const char *chip;
+  uint32_t line;
+  LinuxGpioLine gpio;
+  LinuxPinHook hook;
+  void *context;
+  uint8_t level;
+};
+
+static PinMap pins[LINUX_MAX_PINS];
+
+bool LinuxGpio::mapPin(uint8_t pin, const char *chip, uint32_t line)
+{
+  if(pin >= LINUX_MAX_PINS){
+    return false;
+  }
+  pins[pin].gpio.close();
+  pins[pin].chip = chip;
+  pins[pin].line = line;
+  return true;
+}
+
+void LinuxGpio::hookPin(uint8_t pin, LinuxPinHook hook, void *context)
+{
+  if(pin < LINUX_MAX_PINS){
+    pins[pin].hook = hook;
+    pins[pin].context = context;
+  }
+}
+
+static void sleepNs(uint64_t ns)
+{
+  struct timespec ts;
+  ts.tv_sec = ns / 1000000000ULL;
+  ts.tv_nsec = ns % 1000000000ULL;
+  while(clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, &ts) == EINTR){
+  }
+}
+
+
+//////// Pins /////////////////
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if(pin >= LINUX_MAX_PINS || pins[pin].hook != nullptr || pins[pin].chip == nullptr){
+    return;
+  }
+  if(mode == INPUT_PULLUP){
+    pins[pin].level = HIGH;
+  }
+  pins[pin].gpio.open(pins[pin].chip, pins[pin].line, mode == OUTPUT, pins[pin].level);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  if(pin >= LINUX_MAX_PINS){
+    return;
+  }
+  PinMap &p = pins[pin];
+  p.level = val ? HIGH : LOW;
+  if(p.hook != nullptr){
+    p.hook(p.context, p.level);
+  }
+  else{
+    p.gpio.write(p.level);
+  }
+}
+
+//Unmapped pins read high, so a wait for DOUT low times out rather than
+//reading garbage
+int digitalRead(uint8_t pin)
+{
+  if(pin >= LINUX_MAX_PINS || !pins[pin].gpio.isOpen()){
+    return HIGH;
+  }
+  int level = pins[pin].gpio.read();
+  return level < 0 ? HIGH : level;
+}
+
+
+//////// Time /////////////////
+
+unsigned long millis()
+{
+  return (unsigned long)(LinuxSys::nowNs() / 1000000ULL);
+}
+
+unsigned long micros()
+{
+  return (unsigned long)(LinuxSys::nowNs() / 1000ULL);
+}
+
+void delay(unsigned long ms)
+{
+  sleepNs((uint64_t)ms * 1000000ULL);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  sleepNs((uint64_t)us * 1000ULL);
+}
+
+void yield()
+{
+  sleepNs(LINUX_YIELD_NS);
+}
+
+
+//////// Interrupts, not available /////////////////
+
+void attachInterrupt(uint8_t interruptNum, void (*isr)(void), int mode)
+{
+  (void)interruptNum; (void)isr; (void)mode;
+}
+
+void detachInterrupt(uint8_t interruptNum)
+{
+  (void)interruptNum;
+}
+
+void noInterrupts() {}
+void interrupts() {}
+
+
+//////// SPI /////////////////
+
+//Nothing goes through SPIClass on Linux, pass the AD7794 a
+//LinuxSpidevTransport. This is here for the driver's default transport.
+void SPIClass::begin() {}
+void SPIClass::end() {}
+void SPIClass::beginTransaction(SPISettings settings) { (void)settings; }
+void SPIClass::endTransaction() {}
+void SPIClass::usingInterrupt(int interruptNumber) { (void)interruptNumber; }
+uint8_t SPIClass::transfer(uint8_t data) { (void)data; return 0xFF; }
+uint16_t SPIClass::transfer16(uint16_t data) { (void)data; return 0xFFFF; }
+void SPIClass::transfer(void *buf, size_t count) { memset(buf, 0xFF, count); }
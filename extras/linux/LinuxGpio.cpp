@@ -0,0 +1,86 @@
+/*
+  LinuxGpio.cpp - GPIO character device lines for the Linux backend.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#include <fcntl.h>
+#include <string.h>
+#include <linux/gpio.h>
+#include "LinuxGpio.h"
+#include "LinuxSys.h"
+
+bool LinuxGpioLine::open(const char *chip, uint32_t line, bool output, uint8_t level)
+{
+  close();
+
+  int chipFd = LinuxSys::open(chip, O_RDWR);
+  if(chipFd < 0){
+    return false;
+  }
+
+  struct gpio_v2_line_request req;
+  memset(&req, 0, sizeof(req));
+  req.offsets[0] = line;
+  req.num_lines = 1;
+  strncpy(req.consumer, "NHB_AD7794", sizeof(req.consumer) - 1);
+  req.config.flags = output ? GPIO_V2_LINE_FLAG_OUTPUT : GPIO_V2_LINE_FLAG_INPUT;
+  if(output){
+    req.config.num_attrs = 1;
+    req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+    req.config.attrs[0].attr.values = level ? 1 : 0;
+    req.config.attrs[0].mask = 1;
+  }
+
+  int rc = LinuxSys::ioctl(chipFd, GPIO_V2_GET_LINE_IOCTL, &req);
+  LinuxSys::close(chipFd);
+  if(rc < 0){
+    return false;
+  }
+  fd = req.fd;
+  return true;
+}
+
+void LinuxGpioLine::close()
+{
+  if(fd >= 0){
+    LinuxSys::close(fd);
+    fd = -1;
+  }
+}
+
+bool LinuxGpioLine::write(uint8_t level)
+{
+  struct gpio_v2_line_values values;
+  values.bits = level ? 1 : 0;
+  values.mask = 1;
+  return fd >= 0 && LinuxSys::ioctl(fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) == 0;
+}
+
+int LinuxGpioLine::read()
+{
+  struct gpio_v2_line_values values;
+  values.bits = 0;
+  values.mask = 1;
+  if(fd < 0 || LinuxSys::ioctl(fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0){
+    return -1;
+  }
+  return values.bits & 1;
+}
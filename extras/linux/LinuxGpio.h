@@ -0,0 +1,61 @@
+/*
+  LinuxGpio.h - One GPIO line through the Linux GPIO character device
+  (/dev/gpiochipN, uAPI v2), and the Arduino pin number to line map used by
+  pinMode()/digitalWrite()/digitalRead() in the Linux backend.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#ifndef LINUX_GPIO_h
+#define LINUX_GPIO_h
+
+#include <stdint.h>
+
+class LinuxGpioLine
+{
+  public:
+    constexpr LinuxGpioLine() : fd(-1) {}   //Constant initialised, usable from other static constructors
+    ~LinuxGpioLine() { close(); }
+
+    bool open(const char *chip, uint32_t line, bool output, uint8_t level);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+
+    bool write(uint8_t level);
+    int read();   //-1 on error
+
+  private:
+    int fd;       //Line request fd, the chip fd is closed once the line is held
+};
+
+typedef void (*LinuxPinHook)(void *context, uint8_t level);
+
+namespace LinuxGpio
+{
+  //Routes an Arduino pin number to a line. The line is requested on
+  //pinMode(), as an output at the last level written.
+  bool mapPin(uint8_t pin, const char *chip, uint32_t line);
+
+  //digitalWrite() on pin calls hook instead of touching a line. Used by
+  //LinuxSpidevTransport to see the driver's chip select edges.
+  void hookPin(uint8_t pin, LinuxPinHook hook, void *context);
+}
+
+#endif
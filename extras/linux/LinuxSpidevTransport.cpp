@@ -0,0 +1,211 @@
+/*
+  LinuxSpidevTransport.cpp - spidev transport with batched messages, see
+  LinuxSpidevTransport.h.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#include <fcntl.h>
+#include <string.h>
+#include "NHB_AD7794.h"
+#include "LinuxSpidevTransport.h"
+#include "LinuxSys.h"
+
+#define AD7794_WRITE_IO_REG  0x28
+
+LinuxSpidevTransport::LinuxSpidevTransport(const char *device, uint8_t csPin)
+  : LinuxSpidevTransport(device, csPin, nullptr, 0)
+{
+}
+
+LinuxSpidevTransport::LinuxSpidevTransport(const char *device, uint8_t csPin, const char *gpioChip, uint32_t csLine)
+  : device(device), csPin(csPin), gpioChip(gpioChip), csLine(csLine), fd(-1), mode(0xFF),
+    speedHz(4000000), batching(true), xferCount(0), used(0), messageCount(0), errorCount(0)
+{
+  LinuxGpio::hookPin(csPin, csHook, this);
+}
+
+LinuxSpidevTransport::~LinuxSpidevTransport()
+{
+  LinuxGpio::hookPin(csPin, nullptr, nullptr);
+  if(fd >= 0){
+    LinuxSys::close(fd);
+  }
+}
+
+void LinuxSpidevTransport::begin()
+{
+  if(fd < 0){
+    fd = LinuxSys::open(device, O_RDWR);
+    uint8_t bits = 8;
+    if(fd >= 0){
+      LinuxSys::ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits);
+    }
+  }
+  if(gpioChip != nullptr && !csGpio.isOpen()){
+    csGpio.open(gpioChip, csLine, true, 1);
+  }
+}
+
+void LinuxSpidevTransport::setBatching(bool enabled)
+{
+  flush();
+  batching = enabled;
+}
+
+void LinuxSpidevTransport::beginTransaction(const SPISettings &settings)
+{
+  //Arduino SPI_MODEn values are AVR SPCR bits, CPOL/CPHA sit at bits 3..2
+  uint8_t m = (settings.dataMode >> 2) & 0x03;
+  if(settings.bitOrder == LSBFIRST){
+    m |= SPI_LSB_FIRST;
+  }
+  if(gpioChip != nullptr){
+    m |= SPI_NO_CS;
+  }
+  if(fd >= 0 && m != mode && LinuxSys::ioctl(fd, SPI_IOC_WR_MODE, &m) == 0){
+    mode = m;
+  }
+  speedHz = settings.clock;
+}
+
+void LinuxSpidevTransport::endTransaction()
+{
+  flush();
+}
+
+uint8_t LinuxSpidevTransport::transfer(uint8_t data)
+{
+  transfer(&data, 1);
+  return data;
+}
+
+void LinuxSpidevTransport::transfer(uint8_t *buf, uint16_t len)
+{
+  if(len == 0){
+    return;
+  }
+  if(batching && writeOnly(buf, len)){
+    if(!queue(buf, len, false)){
+      flush();
+      if(!queue(buf, len, false)){
+        errorCount++;
+      }
+    }
+    return;
+  }
+
+  if(!queue(buf, len, true)){
+    flush();
+    if(!queue(buf, len, true)){
+      memset(buf, 0xFF, len);
+      errorCount++;
+      return;
+    }
+  }
+  uint16_t at = used - len;
+  flush();
+  memcpy(buf, &rx[at], len);
+}
+
+void LinuxSpidevTransport::csHook(void *context, uint8_t level)
+{
+  static_cast<LinuxSpidevTransport *>(context)->select(level);
+}
+
+void LinuxSpidevTransport::select(uint8_t level)
+{
+  if(gpioChip != nullptr){
+    //User space CS, everything queued belongs to the window being closed
+    flush();
+    csGpio.write(level);
+  }
+  else if(level == HIGH && xferCount > 0){
+    endsWindow[xferCount - 1] = true;
+  }
+}
+
+/* writeOnly - True if buf is nothing but AD7794 register writes, i.e. the
+   driver won't look at what comes back.
+*/
+bool LinuxSpidevTransport::writeOnly(const uint8_t *buf, uint16_t len)
+{
+  uint16_t i = 0;
+  while(i < len){
+    switch(buf[i]){
+      case AD7794_WRITE_MODE_REG:
+      case AD7794_WRITE_CONF_REG:
+        i += 3;
+        break;
+      case AD7794_WRITE_IO_REG:
+        i += 2;
+        break;
+      case AD7794_WRITE_OFFSET_REG:
+      case AD7794_WRITE_FS_REG:
+        i += 4;
+        break;
+      default:
+        return false;
+    }
+  }
+  return i == len;
+}
+
+bool LinuxSpidevTransport::queue(const uint8_t *buf, uint16_t len, bool reply)
+{
+  if(xferCount >= LINUX_SPI_MAX_XFERS || used + len > LINUX_SPI_BUF_SIZE){
+    return false;
+  }
+  memcpy(&tx[used], buf, len);
+
+  struct spi_ioc_transfer &x = xfers[xferCount];
+  memset(&x, 0, sizeof(x));
+  x.tx_buf = (uintptr_t)&tx[used];
+  x.rx_buf = reply ? (uintptr_t)&rx[used] : 0;
+  x.len = len;
+  x.speed_hz = speedHz;
+  x.bits_per_word = 8;
+  endsWindow[xferCount] = false;
+
+  xferCount++;
+  used += len;
+  return true;
+}
+
+void LinuxSpidevTransport::flush()
+{
+  if(xferCount == 0){
+    return;
+  }
+
+  //cs_change between frames of different windows deselects in between.
+  //On the last frame it would keep CS asserted after the message, so not.
+  for(uint8_t i = 0; i < xferCount; i++){
+    xfers[i].cs_change = (i + 1 < xferCount) && endsWindow[i];
+  }
+
+  if(fd < 0 || LinuxSys::ioctl(fd, SPI_IOC_MESSAGE(xferCount), xfers) < 0){
+    memset(rx, 0xFF, used); //Reads as "not ready" to the driver, which times out
+    errorCount++;
+  }
+  messageCount++;
+  xferCount = 0;
+  used = 0;
+}
@@ -0,0 +1,95 @@
+/*
+  LinuxSpidevTransport.h - AD7794_Transport on a Linux spidev node, with
+  chip select either from spidev itself or on a GPIO character device line.
+
+  The driver's CS edges (digitalWrite() on its CS pin) are hooked by the
+  transport. Frames that only write registers (mode, conf, IO, offset,
+  full-scale) are queued, not sent, and go out in the same SPI_IOC_MESSAGE
+  as the next frame whose reply the driver needs, or at endTransaction().
+  With spidev driving CS, frames from several CS windows of one transaction
+  share a message too (cs_change between them). Frames that read, and
+  anything that doesn't parse as AD7794 register writes (the reset, CREAD
+  data), go out straight away.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#ifndef LINUX_SPIDEV_TRANSPORT_h
+#define LINUX_SPIDEV_TRANSPORT_h
+
+#include <linux/spi/spidev.h>
+#include "NHB_AD7794Transport.h"
+#include "LinuxGpio.h"
+
+#define LINUX_SPI_MAX_XFERS  16    //Frames per SPI_IOC_MESSAGE
+#define LINUX_SPI_BUF_SIZE   256   //Bytes queued per message
+
+class LinuxSpidevTransport : public AD7794_Transport
+{
+  public:
+    //CS from spidev, the controller's own or cs-gpios in the device tree
+    LinuxSpidevTransport(const char *device, uint8_t csPin);
+    //CS on a GPIO line driven from user space, spidev opened with SPI_NO_CS
+    LinuxSpidevTransport(const char *device, uint8_t csPin, const char *gpioChip, uint32_t csLine);
+    ~LinuxSpidevTransport();
+    LinuxSpidevTransport(const LinuxSpidevTransport &) = delete;   //Holds the CS pin hook
+    LinuxSpidevTransport &operator=(const LinuxSpidevTransport &) = delete;
+
+    void begin();
+    void beginTransaction(const SPISettings &settings);
+    void endTransaction();
+    uint8_t transfer(uint8_t data);
+    void transfer(uint8_t *buf, uint16_t len);
+
+    void setBatching(bool enabled);     //Off: one message per transfer(), for comparison
+    bool isOpen() const { return fd >= 0; }
+    uint32_t messages() const { return messageCount; }  //SPI_IOC_MESSAGE calls
+    uint32_t errors() const { return errorCount; }
+
+  private:
+    static void csHook(void *context, uint8_t level);
+    static bool writeOnly(const uint8_t *buf, uint16_t len);
+    void select(uint8_t level);
+    bool queue(const uint8_t *buf, uint16_t len, bool reply);
+    void flush();
+
+    const char *device;
+    uint8_t csPin;
+    const char *gpioChip;   //nullptr when spidev drives CS
+    uint32_t csLine;
+    LinuxGpioLine csGpio;
+
+    int fd;
+    uint8_t mode;
+    uint32_t speedHz;
+    bool batching;
+
+    struct spi_ioc_transfer xfers[LINUX_SPI_MAX_XFERS];
+    bool endsWindow[LINUX_SPI_MAX_XFERS];
+    uint8_t xferCount;
+    uint8_t tx[LINUX_SPI_BUF_SIZE];
+    uint8_t rx[LINUX_SPI_BUF_SIZE];
+    uint16_t used;
+
+    uint32_t messageCount;
+    uint32_t errorCount;
+};
+
+#endif
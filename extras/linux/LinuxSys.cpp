@@ -0,0 +1,88 @@
+/*
+  LinuxSys.cpp - System call table and monotonic clock of the Linux
+  backend.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include "LinuxSys.h"
+
+static int realOpen(const char *path, int flags)
+{
+  return ::open(path, flags | O_CLOEXEC);
+}
+
+static int realClose(int fd)
+{
+  return ::close(fd);
+}
+
+static int realIoctl(int fd, unsigned long request, void *arg)
+{
+  return ::ioctl(fd, request, arg);
+}
+
+static const LinuxSysOps realOps = { realOpen, realClose, realIoctl };
+static const LinuxSysOps *ops = &realOps;
+static std::atomic<uint64_t> ioctls(0);
+
+void LinuxSys::setOps(const LinuxSysOps *newOps)
+{
+  ops = (newOps != nullptr) ? newOps : &realOps;
+}
+
+int LinuxSys::open(const char *path, int flags)
+{
+  return ops->open(path, flags);
+}
+
+int LinuxSys::close(int fd)
+{
+  return ops->close(fd);
+}
+
+int LinuxSys::ioctl(int fd, unsigned long request, void *arg)
+{
+  ioctls++;
+  return ops->ioctl(fd, request, arg);
+}
+
+uint64_t LinuxSys::ioctlCount()
+{
+  return ioctls.load();
+}
+
+static uint64_t monotonicNs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t LinuxSys::nowNs()
+{
+  static const uint64_t start = monotonicNs();
+  return monotonicNs() - start;
+}
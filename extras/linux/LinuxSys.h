@@ -0,0 +1,53 @@
+/*
+  LinuxSys.h - The system calls the Linux backend makes (open, close,
+  ioctl), through a table that can be swapped for a fake, see FakeSpidev.
+  Every ioctl is counted, so syscalls per sample can be measured.
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#ifndef LINUX_SYS_h
+#define LINUX_SYS_h
+
+#include <stdint.h>
+
+struct LinuxSysOps
+{
+  int (*open)(const char *path, int flags);
+  int (*close)(int fd);
+  int (*ioctl)(int fd, unsigned long request, void *arg);
+};
+
+namespace LinuxSys
+{
+  //nullptr goes back to the real system calls
+  void setOps(const LinuxSysOps *ops);
+
+  int open(const char *path, int flags);
+  int close(int fd);
+  int ioctl(int fd, unsigned long request, void *arg);
+
+  uint64_t ioctlCount();
+
+  //Monotonic clock, ns since the first call
+  uint64_t nowNs();
+}
+
+#endif
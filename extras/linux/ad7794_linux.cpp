@@ -0,0 +1,192 @@
+/*
+  ad7794_linux.cpp - Reads an AD7794 from Linux user space through spidev.
+  Prints readings and the system calls, SPI messages and time each sample
+  costs, for single conversion reads and for the continuous scan.
+
+  Usage: ad7794_linux /dev/spidevB.C [gpiochip line]   real chip, CS from
+                                                       spidev or a GPIO line
+         ad7794_linux --fake [passes]                  simulated chip, both CS
+                                                       options, batching off/on
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "NHB_AD7794.h"
+#include "LinuxSpidevTransport.h"
+#include "LinuxSys.h"
+#include "FakeSpidev.h"
+#include "AD7794Sim.h"
+
+#define ADC_CS        10      //Only names the CS pin for the hook, no GPIO behind it
+#define FAKE_SPIDEV   "/dev/spidev0.0"
+#define FAKE_CHIP     "/dev/gpiochip0"
+#define FAKE_LINE     5
+
+struct Cost
+{
+  double ioctls;
+  double messages;
+  double us;
+};
+
+static Cost readPasses(AD7794 &adc, LinuxSpidevTransport &port, uint32_t passes, float *out)
+{
+  uint64_t i0 = LinuxSys::ioctlCount();
+  uint32_t m0 = port.messages();
+  uint64_t t0 = LinuxSys::nowNs();
+  for(uint32_t p = 0; p < passes; p++){
+    adc.read(out, 6);
+  }
+  double n = passes * 6.0;
+  return { (LinuxSys::ioctlCount() - i0) / n, (port.messages() - m0) / n, (LinuxSys::nowNs() - t0) / n / 1e3 };
+}
+
+static Cost scanPasses(AD7794 &adc, LinuxSpidevTransport &port, uint32_t passes, float *out)
+{
+  AD7794_Sample s;
+  uint32_t got = 0;
+
+  adc.startScan();
+  uint64_t i0 = LinuxSys::ioctlCount();
+  uint32_t m0 = port.messages();
+  uint64_t t0 = LinuxSys::nowNs();
+  while(got < passes * 6){
+    if(adc.pollScan(s)){
+      out[s.channel] = adc.rawToVolts(s.channel, s.raw);
+      got++;
+    }
+    else{
+      uint32_t wait = adc.getScanWait();
+      delayMicroseconds(wait ? wait : 100);
+    }
+  }
+  Cost c = { (LinuxSys::ioctlCount() - i0) / (double)got, (port.messages() - m0) / (double)got,
+             (LinuxSys::nowNs() - t0) / (double)got / 1e3 };
+  adc.stopScan();
+  return c;
+}
+
+static void setup(AD7794 &adc)
+{
+  adc.begin();
+  adc.setUpdateRate(470);
+  for(uint8_t ch = 0; ch < 6; ch++){
+    adc.setBipolar(ch, true);
+    adc.setGain(ch, 1);
+    adc.setEnabled(ch, true);
+  }
+}
+
+static void printCost(const char *name, const Cost &c, const float *v)
+{
+  printf("%-28s %10.2f %10.2f %10.0f   %.4f %.4f %.4f %.4f %.4f %.4f\n", name, c.ioctls, c.messages, c.us,
+         v[0], v[1], v[2], v[3], v[4], v[5]);
+}
+
+//Both read paths on one transport, checked against the simulated inputs
+static int fakeCase(LinuxSpidevTransport &port, const char *csName, bool batch, uint32_t passes)
+{
+  AD7794 adc(ADC_CS, 4000000, 2.50, port);
+  float v[6] = {0};
+  char name[40];
+  int bad = 0;
+
+  port.setBatching(batch);
+  uint64_t i0 = LinuxSys::ioctlCount();
+  uint32_t m0 = port.messages();
+  setup(adc);
+  printf("%-28s %10.0f %10.0f %10s   (totals)\n", batch ? "setup, batched" : "setup", (double)(LinuxSys::ioctlCount() - i0),
+         (double)(port.messages() - m0), "-");
+
+  snprintf(name, sizeof(name), "read(buf,6), %s CS%s", csName, batch ? ", batched" : "");
+  printCost(name, readPasses(adc, port, passes, v), v);
+  for(uint8_t ch = 0; ch < 6; ch++){
+    if(fabs(v[ch] - 0.1 * (ch + 1)) > 0.001) bad++;
+  }
+
+  snprintf(name, sizeof(name), "scan, %s CS%s", csName, batch ? ", batched" : "");
+  printCost(name, scanPasses(adc, port, passes, v), v);
+  for(uint8_t ch = 0; ch < 6; ch++){
+    if(fabs(v[ch] - 0.1 * (ch + 1)) > 0.001) bad++;
+  }
+  return bad + (port.errors() != 0);
+}
+
+static int runFake(uint32_t passes)
+{
+  FakeSpidev::install();
+  FakeSpidev::bindSpidev(FAKE_SPIDEV, ADC_CS);
+  FakeSpidev::bindGpio(FAKE_CHIP, FAKE_LINE, ADC_CS);
+
+  AD7794Sim sim(ADC_CS);
+  for(uint8_t ch = 0; ch < 6; ch++){
+    sim.setInput(ch, 0.1 * (ch + 1));
+  }
+
+  printf("simulated AD7794, 470 Hz, %u passes of 6 channels\n", passes);
+  printf("%-28s %10s %10s %10s   %s\n", "case", "ioctl/smp", "msg/smp", "us/smp", "last pass (V)");
+
+  int bad = 0;
+  for(uint8_t batch = 0; batch < 2; batch++){
+    {
+      LinuxSpidevTransport port(FAKE_SPIDEV, ADC_CS);
+      bad += fakeCase(port, "spidev", batch, passes);
+    }
+    {
+      LinuxSpidevTransport port(FAKE_SPIDEV, ADC_CS, FAKE_CHIP, FAKE_LINE);
+      bad += fakeCase(port, "GPIO", batch, passes);
+    }
+  }
+  printf("%s\n", bad ? "readings do NOT match the simulated inputs" : "all readings match the simulated inputs");
+  FakeSpidev::uninstall();
+  return bad ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+  if(argc < 2){
+    fprintf(stderr, "usage: %s /dev/spidevB.C [gpiochip line] | --fake [passes]\n", argv[0]);
+    return 2;
+  }
+  if(strcmp(argv[1], "--fake") == 0){
+    return runFake(argc > 2 ? (uint32_t)atoi(argv[2]) : 20);
+  }
+
+  LinuxSpidevTransport port(argv[1], ADC_CS, argc > 3 ? argv[2] : nullptr, argc > 3 ? (uint32_t)atoi(argv[3]) : 0);
+  AD7794 adc(ADC_CS, 4000000, 2.50, port);
+  float v[6];
+
+  port.begin();
+  if(!port.isOpen()){
+    perror(argv[1]);
+    return 1;
+  }
+  setup(adc);
+
+  printf("%-28s %10s %10s %10s   %s\n", "case", "ioctl/smp", "msg/smp", "us/smp", "last pass (V)");
+  for(int i = 0; i < 10; i++){
+    printCost("read(buf,6)", readPasses(adc, port, 10, v), v);
+    printCost("scan", scanPasses(adc, port, 10, v), v);
+  }
+  return port.errors() ? 1 : 0;
+}
@@ -30,8 +30,43 @@
 #include "NHB_AD7794.h"
 #include <SPI.h>
 
+//Keeps the compiler from moving sample writes past the index update
+#define AD7794_BARRIER()  __asm__ __volatile__("" ::: "memory")
+
+//Volts to fixed point microvolts
+#define AD7794_FIXED_PER_VOLT  (1e6 * (1UL << AD7794_FIXED_FRAC_BITS))
+
+static_assert(AD7794_AUTORANGE_HOLD <= 15, "rangeCount is a 4 bit field");
+
+//AD7794_Timing copied into flash for the run time lookups, so AVR keeps
+//the tables out of RAM
+#define AD7794_TABLE16(t)  t[0], t[1], t[2], t[3], t[4], t[5], t[6], t[7], \
+                           t[8], t[9], t[10], t[11], t[12], t[13], t[14], t[15]
+
+static const uint32_t convPeriodTable[16] PROGMEM = { AD7794_TABLE16(AD7794_Timing<>::periodUs) };
+static const uint32_t settleTimeTable[16] PROGMEM = { AD7794_TABLE16(AD7794_Timing<>::settleUs) };
+
+AD7794 *AD7794::irqOwners[AD7794_MAX_IRQ_INSTANCES];
+
+
+//Transport used when none is given, the default SPI port
+static AD7794_SPITransport defaultTransport(SPI);
 
 AD7794::AD7794(uint8_t csPin, uint32_t spiFrequency, double refVoltage)
+{
+  bus = &defaultTransport;
+  init(csPin, spiFrequency, refVoltage);
+}
+
+/* AD7794 - Same as above, on another transport, e.g. an
+   AD7794_SPITransport on a second SPI port */
+AD7794::AD7794(uint8_t csPin, uint32_t spiFrequency, double refVoltage, AD7794_Transport &transport)
+{
+  bus = &transport;
+  init(csPin, spiFrequency, refVoltage);
+}
+
+void AD7794::init(uint8_t csPin, uint32_t spiFrequency, double refVoltage)
 {
   //pinMode(csPin, OUTPUT);
   CS = csPin;
@@ -47,11 +82,66 @@ AD7794::AD7794(uint8_t csPin, uint32_t spiFrequency, double refVoltage)
   modeReg = AD7794_DEFAULT_MODE_REG;     //Single conversion mode, Fadc = 470Hz
   confReg = AD7794_DEFAULT_CONF_REG;     //CH 0 - Bipolar, Gain = 1, Input buffer enabled  
   isSnglConvMode = true;
-
+  contConvStarted = false;
+  currentCh = 0;
+
+  acqState = AD7794_Acq_Idle;
+  acqCh = 0;
+  acqStartTime = 0;
+  acqReadyAt = 0;
+  acqResult = 0;
+  resultFlags = 0;
+
+  lastError = AD7794_Err_None;
+  timeoutCount = 0;
+  statusReads = 0;
+  rejectedCount = 0;
+  rejectRun = 0;
+  updateTimeout();
+
+#ifdef AD7794_ENABLE_STATS
+  resetStats();
+  acqStartUs = 0;
+  scanStartUs = 0;
+#endif
+
+  irqQueue = NULL;
+  drdyPin = MISO;
+  irqSlot = 0;
+  irqActive = false;
+  irqRestoreSingle = false;
+  lastIrqTime = 0;
+  irqOverruns = 0;
+
+  streamActive = false;
+  streamRestoreSingle = false;
+
+  dutyStarted = false;
+  lowPowerMode = 0;
+  dutyLastMs = 0;
+  wakeLatencyUs = 0;
+  scanCharge = 0;
+
+  scanCount = 0;
+  scanIdx = 0;
+  scanDiscards = 0;
+  scanDiscardsLeft = 0;
+  scanActive = false;
+  scanRestoreSingle = false;
+  scanWaitStart = 0;
+
+  //Nothing is known about the chip's registers until reset()
+  chipModeReg = 0;
+  chipConfReg = 0;
+  shadowValid = false;
+  configBatch = false;
+  skippedWrites = 0;
+
+
+  vRef = refVoltage;
+  vRefFixed = (int32_t)(refVoltage * AD7794_FIXED_PER_VOLT + 0.5);
 
   for(int i=0; i<AD7794_CHANNEL_COUNT-2; i++){
-    Channel[i].vRef = refVoltage;
-
     if(refVoltage == AD7794_INTERNAL_REF_V){
       Channel[i].refMode = AD7794_REF_INT;           
     }
@@ -63,21 +153,17 @@ void AD7794::begin()
   pinMode(CS, OUTPUT);
   digitalWrite(CS,HIGH); 
 
-  SPI.begin();
+  bus->begin();
 
   reset();
   delay(2); //4 times the recomended period
 
   //Apply the defaults that were set up in the constructor
   //Should add a begin(,,) method that lets you override the defaults
-  for(uint8_t i = 0; i < AD7794_CHANNEL_COUNT-2; i++){ //<-- Channel count stuff needs to be handled better!!
-    setActiveCh(i);
-    
-    writeModeReg();
-    writeConfReg();
-  }
-
-  setActiveCh(0); //Set channel back to 0
+  //There is only one conf reg on the chip, so only the selected channel's
+  //settings need to go out. The others are written when they get selected.
+  writeModeReg();
+  setActiveCh(0);
 
   read(0); //Take a through away reading because the very first value read is usually junk
 }
@@ -86,41 +172,138 @@ void AD7794::begin()
 void AD7794::reset()
 {
   // Speed set to 4MHz, SPI mode set to MODE 3 and Bit order set to MSB first.  
-  SPI.beginTransaction(spiSettings);
+  bus->beginTransaction(spiSettings);
   digitalWrite(CS, LOW); //Assert CS
-  for(uint8_t i=0;i<4;i++)
-  {
-    SPI.transfer(0xFF);
-  }
+  AD7794Bus::reset(*bus);
+  AD7794_STAT(stats.configBytes += 4);
   digitalWrite(CS, HIGH);
-  SPI.endTransaction();
+  bus->endTransaction();
+
+  //The chip is back to its power-on register values
+  chipModeReg = AD7794_POR_MODE_REG;
+  chipConfReg = AD7794_POR_CONF_REG;
+  shadowValid = true;
+  lowPowerMode = 0;
 }
 
-//Sets bipolar/unipolar mode for currently selected channel
-void AD7794::setBipolar(uint8_t ch, bool isBipolar)
+/* beginConfig / commit - Batch a group of setter calls. Between the two,
+   setters only update the channel settings and the local register images.
+   commit() then writes the mode and conf registers at most once each, and
+   only if they differ from what the chip already holds.
+*/
+void AD7794::beginConfig()
 {
-  setActiveCh(ch);
-  Channel[currentCh].isBipolar = isBipolar;
+  configBatch = true;
+}
+
+void AD7794::commit()
+{
+  configBatch = false;
   buildConfReg();
+  writeModeReg();
   writeConfReg();
 }
 
+/* getSkippedWrites - Number of register writes that were not sent because
+   the chip already held the same value
+*/
+uint32_t AD7794::getSkippedWrites()
+{
+  return skippedWrites;
+}
+
+//Sets bipolar/unipolar mode for the specified channel
+void AD7794::setBipolar(uint8_t ch, bool isBipolar)
+{
+  if(ch < AD7794_CHANNEL_COUNT){
+    Channel[ch].isBipolar = isBipolar;
+    resetFilter(ch);
+    updateChannel(ch);
+  }
+}
+
 void AD7794::setInputBuffer(uint8_t ch, bool isBuffered)
 {
-  Channel[currentCh].isBuffered = isBuffered;
+  if(ch < AD7794_CHANNEL_COUNT){
+    Channel[ch].isBuffered = isBuffered;
+    updateChannel(ch);
+  }
 }
 
 void AD7794::setGain(uint8_t ch, uint8_t gain)
 {
-  setActiveCh(ch);
-  Channel[currentCh].gain = gain;
-  buildConfReg();
-  writeConfReg();
+  if(ch < AD7794_CHANNEL_COUNT){
+    Channel[ch].gainBits = getGainBits(gain);
+    Channel[ch].nextGainBits = Channel[ch].gainBits;
+    Channel[ch].rangeCount = 0;
+    resetFilter(ch);
+    updateChannel(ch);
+  }
+}
+
+//Gain of the latest result, the one rawToVolts() and toFixed() use
+uint8_t AD7794::getGain(uint8_t ch)
+{
+  return ch < AD7794_CHANNEL_COUNT ? 1 << Channel[ch].gainBits : 0;
+}
+
+/* setAutoRange - Lets the gain of a channel follow its input, between
+   minGain and maxGain. Every result read with a status check (poll(),
+   read(), scans) is compared against AD7794_AUTORANGE_DOWN and _UP. A new
+   gain goes out with the next conf write the channel gets anyway, so a
+   range change costs at most one write, and the conversion after it settles
+   like any channel switch. The interrupt and CREAD streaming paths don't
+   range. Results carry the gain they were converted with (getGain(),
+   AD7794_Sample::gain).
+*/
+void AD7794::setAutoRange(uint8_t ch, bool enabled, uint8_t minGain, uint8_t maxGain)
+{
+  if(ch < AD7794_CHANNEL_COUNT){
+    channelSettings &c = Channel[ch];
+    c.autoRange = enabled;
+    c.minGainBits = getGainBits(minGain);
+    c.maxGainBits = getGainBits(maxGain);
+    minGain = 1 << c.minGainBits;
+    maxGain = 1 << c.maxGainBits;
+
+    uint8_t gain = 1 << c.gainBits;
+    if(enabled && gain < minGain){
+      gain = minGain;
+    }
+    else if(enabled && gain > maxGain){
+      gain = maxGain;
+    }
+    setGain(ch, gain); //Also drops a pending change
+  }
+}
+
+/* setFilter - Attaches a filter (or chain of filters) to a channel, nullptr
+   removes it. Every raw result of the channel goes through the filter before
+   it is returned or queued, on all the read paths. The filter object is
+   owned by the caller and must outlive its use here. A filter with a ratio
+   above 1 (decimator) makes the driver convert that many times per result.
+*/
+void AD7794::setFilter(uint8_t ch, AD7794_Filter *filter)
+{
+  if(ch < AD7794_CHANNEL_COUNT){
+    Channel[ch].filter = filter;
+    resetFilter(ch);
+  }
+}
+
+//Clears the filter history of a channel, e.g. after its input changed
+void AD7794::resetFilter(uint8_t ch)
+{
+  if(ch < AD7794_CHANNEL_COUNT && Channel[ch].filter != nullptr){
+    Channel[ch].filter->reset();
+  }
 }
 
 void AD7794::setEnabled(uint8_t ch, bool enabled)
 {
-  Channel[currentCh].isEnabled = enabled;
+  if(ch < AD7794_CHANNEL_COUNT){
+    Channel[ch].isEnabled = enabled;
+  }
 }
 
 /******************************************************
@@ -135,46 +318,47 @@ refer to datasheet for modes
   0   |  0  |  1  |  1  |  123           |  16
   0   |  1  |  0  |  0  |   62           |  32
   ....
+
+  Every channel carries its own rate, which is loaded into the mode register
+  when the channel is selected. This version sets all of them.
+  Noise rejection of the slow settings:
+    0x0F = 74 dB, 0x0E = 72 dB, 0x0D = 70 dB, 0x0C = 69 dB, 0x0B = 66 dB,
+    0x0A = 65 dB (50 Hz and 60 Hz), 0x08 = 90 dB (60 Hz only) *Should be
+    best option in US. 16.7 Hz could also be 0x09 (80 dB at 50 Hz only).
 */
 void AD7794::setUpdateRate(double rate)
 {
-  uint8_t bitMask;
-  //Map requested to next available range
-  if(rate <= 4.17)
-    {bitMask = 0x0F;}     //0x0F = 74 dB (50 Hz and 60 Hz) 
-  else if(rate > 4.17 && rate <= 6.25)
-    {bitMask = 0x0E;}     //0x0E = 72 dB (50 Hz and 60 Hz)
-  else if(rate > 6.25 && rate <= 8.33)
-    {bitMask = 0x0D;}     //0x0D = 70 dB (50 Hz and 60 Hz)
-  else if(rate > 8.33 && rate <= 10)
-    {bitMask = 0x0C;}     //0x0C = 69 dB (50 Hz and 60 Hz) 
-  else if(rate > 10 && rate <= 12.5)
-    {bitMask = 0x0B;}     //0x0B = 66 dB (50 Hz and 60 Hz)
-  else if(rate > 12.5 && rate <= 16.7) //This ones wierd, have to pick one 
-    {bitMask = 0x0A;}     //0x0A = 65 dB(50Hx and 60Hz)
-    //{bitMask = 0x09;}   //0x09 = 80 dB(50Hz)65 dB(50Hx and 60Hz)
-  else if(rate > 16.7 && rate <= 19.6)
-    {bitMask = 0x08;}     //0x08 = 90 dB(60 Hz only) *Should be best option in US
-  else if(rate > 19.6 && rate <= 33.2)
-    {bitMask = 0x07;}
-  else if(rate > 33.2 && rate <= 39)
-    {bitMask = 0x06;}
-  else if(rate > 39 && rate <= 50)
-    {bitMask = 0x05;}
-  else if(rate > 50 && rate <= 62)
-    {bitMask = 0x04;}
-  else if(rate > 62 && rate <= 123)
-    {bitMask = 0x03;}
-  else if(rate > 123 && rate <= 242)
-    {bitMask = 0x02;}
-    else if(rate > 242)
-      {bitMask = 0x01;} //anything above 242 set to 470 Hz
-
-  modeReg &= 0xFFF0; //Zero off low nibble
-  modeReg |= bitMask;
+  uint8_t bitMask = AD7794_rateCode(rate); //Map requested to next available range
+
+  for(uint8_t i = 0; i < AD7794_CHANNEL_COUNT; i++){
+    Channel[i].rateCode = bitMask;
+  }
+  loadChannelMode(currentCh);
 
   writeModeReg();
-  //TODO: Put table from datasheet in comments, in header file
+}
+
+/* setUpdateRate - Update rate of one channel. In a scan, channels with
+   different rates are grouped so the mode register is only rewritten when
+   the rate actually changes, and fast channels keep their rate.
+*/
+void AD7794::setUpdateRate(uint8_t ch, double rate)
+{
+  if(ch < AD7794_CHANNEL_COUNT){
+    Channel[ch].rateCode = AD7794_rateCode(rate);
+    if(ch == currentCh && loadChannelMode(ch)){
+      writeModeReg();
+    }
+  }
+}
+
+//Actual update rate (Hz) a channel converts at
+float AD7794::getUpdateRate(uint8_t ch)
+{
+  if(ch >= AD7794_CHANNEL_COUNT){
+    return 0;
+  }
+  return 1e6 / (float)convPeriodUs(channelModeBits(ch));
 }
 
 //Deprecated
@@ -195,9 +379,20 @@ void AD7794::setUpdateRate(double rate)
 
 void AD7794::setMode(AD7794_OperatingModes mode){
 
-  //Currently only continuous and single conversion mode are supported
+  if(mode >= AD7794_OpMode_InternalZeroCalibration){
+    return; //Calibrations are per channel, use calibrate()
+  }
+  if(mode == AD7794_OpMode_Idle || mode == AD7794_OpMode_PowerDown){
+    enterLowPower(mode);
+    return;
+  }
+
+  //The mode select bits (MD2..MD0) are the top 3 bits of the mode register
   modeReg &= 0x1FFF;
-  modeReg |= mode << 1;
+  modeReg |= (uint16_t)mode << 13;
+  contConvStarted = false;
+  scanActive = false;
+  lowPowerMode = 0;
 
   //Temporary hack, need to change all references to isSglConvMode
   if(mode == AD7794_OpMode_SingleConv){
@@ -214,298 +409,1877 @@ void AD7794::setMode(AD7794_OperatingModes mode){
 //Enable internal bias voltage for specified channel
 void AD7794::setVBias(uint8_t ch, bool isEnabled)
 {
-  setActiveCh(ch);
-  Channel[currentCh].vBiasEnabled = isEnabled;
-  buildConfReg();
-  writeConfReg();
+  if(ch < AD7794_CHANNEL_COUNT){
+    Channel[ch].vBiasEnabled = isEnabled;
+    updateChannel(ch);
+  }
 }
 
 //Set the votage reference source for the specified channel
 void AD7794::setRefMode(uint8_t ch, uint8_t mode){
-  
-  setActiveCh(ch);
 
   //Only 0,1,2 are valid
-  if(mode < 3){ 
-    Channel[currentCh].refMode = mode;
-    buildConfReg();
-    writeConfReg();
+  if(ch < AD7794_CHANNEL_COUNT && mode < 3){ 
+    Channel[ch].refMode = mode;
+    updateChannel(ch);
   }
 
 }
 
 //Added 11-14-2021
+//Sets chop for every channel, see setChopEnabled(ch, enabled) for one
 void AD7794::setChopEnabled(bool enabled){
-  // 0x0210 = chopp disabled
-  if(enabled == true){    
-    modeReg &= ~ AD7794_CHOP_DISABLE;    
-  }
-  else{    
-    modeReg |= AD7794_CHOP_DISABLE;
+  for(uint8_t i = 0; i < AD7794_CHANNEL_COUNT; i++){
+    Channel[i].chopEnabled = enabled;
   }
+  loadChannelMode(currentCh);
 
   writeModeReg();
 }
 
-// OK, for now I'm not going to handle the spi transaction inside the startConversion()
-// and getConvResult() functions. They are very low level and the behavior is different
-// depending on conversion mode (and other things ?). think I will make these private
-// and create a higher level functions to get readings.
-uint32_t AD7794::getConvResult()
+void AD7794::setChopEnabled(uint8_t ch, bool enabled)
 {
-  uint8_t inByte;
-  uint32_t result = 0;
-
-  //SPI.beginTransaction(spiSettings); //We should still be in our transaction
-  SPI.transfer(AD7794_READ_DATA_REG);
-
-  //Read 24 bits one byte at a time, and put in an unsigned long
-  inByte = SPI.transfer(0xFF); //dummy byte
-  result = inByte;
-  inByte = SPI.transfer(0xFF); //dummy byte
-  result = result << 8;
-  result = result | inByte;
-  inByte = SPI.transfer(0xFF); //dummy byte
-  result = result << 8;
-  result = result | inByte;
-
-  //De-assert CS if not in continous conversion mode
-  if(isSnglConvMode){
-    digitalWrite(CS,HIGH);
+  if(ch < AD7794_CHANNEL_COUNT){
+    Channel[ch].chopEnabled = enabled;
+    if(ch == currentCh && loadChannelMode(ch)){
+      writeModeReg();
+    }
   }
-
-  return result;
 }
 
-//Experiment with reading all active channels, this may be the way I go in the future UNTESTED
-void AD7794::read(float *buf, uint8_t bufSize)
+// getConvResult() and readStatusReg() don't handle the spi transaction or CS.
+// They are very low level and are always called from inside a transaction
+// with CS already asserted, so a status check and the data read can share one.
+uint32_t AD7794::getConvResult()
 {
-  uint8_t readingCnt = 0 ;
-
-  for(int i = 0;  i < AD7794_CHANNEL_COUNT; i++){
-    if(Channel[i].isEnabled){
-      if(readingCnt < bufSize){
-        buf[readingCnt] = read(i);
-      }else{
-        //buffer too small!
-        //Maybe return an error code?
-      }
-      readingCnt++;
-    }
-  }
+  AD7794_STAT(stats.dataBytes += 4);
+  return AD7794Bus::readData(*bus);
 }
 
-/* read - The single channel version
-   Gets reading from a single channel. Right now it
-   is in volts (default scailing), but I may have it use
-   a scaling setting stored for each channel. I might also
-   just save that for a higher level hardware abstraction class.
-*/
-float AD7794::read(uint8_t ch)
+//Same rules as getConvResult(), CS must already be asserted
+uint8_t AD7794::readStatusReg()
 {
-  //Lets the conversion result
-  uint32_t adcRaw = getReadingRaw(ch);
-  //Serial.print(adcRaw);
-  //Serial.print(' ');
-  float result;
+  AD7794_STAT(stats.statusPolls++; stats.dataBytes += 2);
+  return AD7794Bus::readStatus(*bus);
+}
 
-  if(ch == 6){ //Channel 6 is temperature, handle it differently due to 1.17 V internal Ref
-    //return (((float)adcRaw / AD7794_ADC_MAX_BP - 1) * 1.17)*100; //Bipolar, not sure what mode for temp sensor
-    return TempSensorRawToDegC(adcRaw);    
+//Offset and full-scale registers are banked, the one for the channel
+//selected in the conf reg is the one that is accessed
+uint32_t AD7794::readReg24(uint8_t ch, uint8_t cmd)
+{
+  if(ch >= AD7794_CAL_CHANNEL_COUNT || irqActive || streamActive){
+    return 0;
   }
-
-  //And convert to Volts, note: no error checking
-  if(!Channel[currentCh].isBipolar){
-    result = (adcRaw * Channel[currentCh].vRef) / (AD7794_ADC_MAX_UP * Channel[currentCh].gain);            //Unipolar formula
-    //Serial.print("unipolar");
+  if(configBatch){
+    commit(); //The channel has to really be selected
   }
-  else{
-    result = (((float)adcRaw / AD7794_ADC_MAX_BP - 1) * Channel[currentCh].vRef) / Channel[currentCh].gain; //Bipolar formula    
-    //Serial.print("bipolar");
+  if(scanActive){
+    stopScan();
   }
+  setActiveCh(ch);
 
-  return result - Channel[currentCh].offset;
-}
+  bus->beginTransaction(spiSettings);
+  digitalWrite(CS,LOW);
+  AD7794_STAT(stats.configBytes += 4);
+  uint32_t value = AD7794Bus::readReg24(*bus, cmd);
+  digitalWrite(CS,HIGH);
+  bus->endTransaction();
 
-/* Convert AD7794X on-chip temp sensor readings to Deg C */
-float AD7794::TempSensorRawToDegC(uint32_t rawData)  {
-        float volts = ((float)rawData - 0x800000) * (AD7794_INTERNAL_REF_V / AD7794_ADC_MAX_BP);
-        float degK = volts/0.00081; //Sensitivity = 0.81 mv/DegC
-        float degC = degK - 273;                
-        return(degC);
+  return value;
 }
 
-/* zero - Record offsets to apply to the channel (if active) */
-void AD7794::zero(uint8_t ch)
-{  
-  
-  if(Channel[ch].isEnabled == true){
-    //read(ch); //Take a throw away reading first -This is now done in begin,shouldn't be needed here anymore
-    
-    Channel[ch].offset = read(ch);    
+void AD7794::writeReg24(uint8_t ch, uint8_t cmd, uint32_t value)
+{
+  if(ch >= AD7794_CAL_CHANNEL_COUNT || irqActive || streamActive){
+    return;
   }
-}
-
-/* zero - Record offsets to apply to all active
-   channels. (NOT temperature an AVDD monitor)
-*/
-void AD7794::zero()
-{ 
-  for(int i = 0;  i < AD7794_CHANNEL_COUNT-2 ; i++){
-    zero(i);
+  if(configBatch){
+    commit(); //The channel has to really be selected
+  }
+  if(scanActive){
+    stopScan();
   }
+  setActiveCh(ch);
+
+  bus->beginTransaction(spiSettings);
+  digitalWrite(CS,LOW);
+  AD7794_STAT(stats.configBytes += 4);
+  AD7794Bus::writeReg24(*bus, cmd, value);
+  digitalWrite(CS,HIGH);
+  bus->endTransaction();
 }
 
-/* offset - Returns channel offset value. I'm not sure if this will be needed
-   in the long run, but it's usefull for testing now.
+/* startReading - Selects the channel and starts a conversion, then releases
+   the bus. In continuous mode the conversion is only (re)started when it is
+   not already running on this channel. Use poll() to find out when it is done.
 */
-float AD7794::offset(uint8_t ch)
+bool AD7794::startReading(uint8_t ch)
 {
-  return Channel[ch].offset;
-}
+  if(ch >= AD7794_CHANNEL_COUNT){
+    return false;
+  }
 
-//Added 11-14-2021
-int AD7794::waitForConvReady (uint32_t timeout){
-  uint8_t inByte;
-  uint32_t t = millis();
+  if(configBatch){
+    commit();
+  }
+  if(scanActive){
+    stopScan();
+  }
 
-  while((millis() - t) <= timeout){
-    
-    SPI.transfer(AD7794_READ_STATUS_REG);
+  acqReadyAt = micros(); //Continuous on the same channel, a result may be due any time
 
-    //Read status register
-    inByte = SPI.transfer(0xFF); //dummy byte
-    if((inByte & 0x80) == 0){
-      //bit cleared, conversion is ready
-      return 0;
-    }
+  if(isSnglConvMode || !contConvStarted){
+    startConv(ch);
+    contConvStarted = !isSnglConvMode;
+    acqReadyAt = micros() + settleTimeUs();
   }
-  return -1;
+  else if(ch != currentCh || rangePending(ch)){
+    setActiveCh(ch); //Writing the conf reg restarts the running conversion
+    acqReadyAt = micros() + settleTimeUs();
+  }
+
+  acqCh = ch;
+  resultFlags = 0;
+  rejectRun = 0;
+  acqStartTime = millis();
+  AD7794_STAT(acqStartUs = micros());
+  acqState = AD7794_Acq_Converting;
+  return true;
 }
 
-// This function is BLOCKING. I'm not sure if it is even possible to make a
-// non blocking version with this chip on a shared SPI bus.
-uint32_t AD7794::getReadingRaw(uint8_t ch)
+/* poll - Checks RDY with a single status register read. If the conversion
+   is done, the result is read in the same transaction. The same status byte
+   validates the result: one from another channel is dropped without reading
+   it (see checkResultChannel()) and the ERR bit is kept in getResultFlags().
+   Returns the new state.
+*/
+AD7794_AcqState AD7794::poll()
 {
-  static bool contConvStarted = false;
-  // setActiveCh() also calls SPI.beginTransaction(), This causes a lockup on esp32
-  // so the call has been moved down.
-  //SPI.beginTransaction(spiSettings);
-  
-  if(isSnglConvMode || !contConvStarted){ //Added 11-14-2021
-    
-    setActiveCh(ch);
-  
-    SPI.beginTransaction(spiSettings); 
-  
-    startConv();
-    contConvStarted = true;
+  if(acqState != AD7794_Acq_Converting){
+    return acqState;
   }
-  
-  if(!isSnglConvMode){ //Added 11-14-2021
-    digitalWrite(CS,LOW); //It seems I need to re-assert this. Not sure why, I don't think it gets set HIGH anywhere when in continuous read mode ????
+
+  //No point asking the chip before the conversion can be done
+  if((int32_t)(micros() - acqReadyAt) < 0){
+    return acqState;
   }
-  //uint32_t t = millis();
-  
-  // #if defined (ESP8266) //Workaround until I figure out how to read the MISO pin status on the ESP8266
-  //   delay(10);           //This delay is only appropriate for the fastest rate (470 Hz)   
-  // #else   
-    
-    //Commented out to test status reg read method
-    // while(digitalRead(MISO) == HIGH){    
-    //   if((millis() - t) >= convTimeout){        
-    //     //Serial.print("getReadingRaw Timeout");
-    //     break;
-    //   }  
-    // }
 
-    //Test status read method NOTE: Should do something with return value (-1 if timeout)
-    waitForConvReady(convTimeout);
+  bus->beginTransaction(spiSettings);
+  digitalWrite(CS,LOW);
+
+  bool needMore = false;
+  bool rejected = false;
+  statusReads++;
+
+  uint8_t status = readStatusReg();
+  if((status & AD7794_STATUS_RDY) != 0){
+    //Still converting
+  }
+  else if(!checkResultChannel(status, acqCh)){
+    rejected = true;
+  }
+  else{
+    //RDY bit cleared, conversion is ready
+    if(status & AD7794_STATUS_ERR){
+      resultFlags |= AD7794_FLAG_RANGE;
+    }
+    uint32_t raw = getConvResult();
+    rejectRun = 0;
+    trackRange(acqCh, (chipConfReg >> 8) & 0x07, raw, status);
+    if(filterSample(acqCh, raw)){
+      acqResult = raw;
+      acqState = AD7794_Acq_Ready;
+      AD7794_STAT(recordWait(acqCh, acqStartUs));
+    }
+    else{
+      needMore = true; //Filter wants more samples (decimation)
+    }
+  }
 
-  // #endif
+  digitalWrite(CS,HIGH);
+  bus->endTransaction();
 
-  uint32_t adcRaw = getConvResult();
+  if(needMore){
+    if(isSnglConvMode){
+      startConv();
+      acqReadyAt = micros() + settleTimeUs();
+    }
+    else{
+      acqReadyAt = micros() + convPeriodUs() - convPeriodUs() / 8; //Next result, a little early
+    }
+    acqStartTime = millis();
+  }
+  if(rejected){
+    contConvStarted = !isSnglConvMode;
+    acqReadyAt = micros() + settleTimeUs();
+    //The reselected channel gets a fresh timeout, but a status that keeps
+    //naming another channel (e.g. MISO stuck low) must still time out
+    if(++rejectRun <= AD7794_REJECT_RETRIES){
+      acqStartTime = millis();
+    }
+  }
 
-  if(isSnglConvMode){ //Added 11-14-2021
-    SPI.endTransaction();
+  if(acqState == AD7794_Acq_Converting && (millis() - acqStartTime) > convTimeout){
+    acqState = AD7794_Acq_Timeout;
+    setError(AD7794_Err_Timeout);
   }
-  return adcRaw;
+
+  return acqState;
 }
 
-void AD7794::setActiveCh(uint8_t ch)
+bool AD7794::resultReady()
 {
-  if(ch < AD7794_CHANNEL_COUNT){
-    currentCh = ch;
-    buildConfReg();
-    writeConfReg();
-  }
+  return poll() == AD7794_Acq_Ready;
 }
 
-// OK, for now I'm not going to handle the spi transaction inside the startConversion()
-// and getConvResult() functions. They are very low level and the behavior is different
-// depending on conversion mode (and other things ?). think I will make these private
-// and create a higher level functions to get readings.
-void AD7794::startConv()
+/* getResultRaw - Returns the result of the last reading started with
+   startReading() and frees the engine for the next one.
+*/
+uint32_t AD7794::getResultRaw()
 {
-  //Write out the mode reg, but leave CS asserted (LOW)
-  //SPI.beginTransaction(spiSettings);
-  digitalWrite(CS,LOW);
-  SPI.transfer(AD7794_WRITE_MODE_REG);
-  // SPI.transfer(highByte(modeReg));
-  // SPI.transfer(lowByte(modeReg));
+  acqState = AD7794_Acq_Idle;
+  return acqResult;
+}
 
-  SPI.transfer16(modeReg);
+float AD7794::getResult()
+{
+  return rawToVolts(acqCh, getResultRaw());
+}
 
-  //Don't end the transaction yet. for now this is going to have to hold on
-  //to the buss until the conversion is complete. not sure if there is a way around this
+/* getResultFlags - AD7794_FLAG_xxx for the last result from poll() or
+   getReadingRaw(). With a decimating filter it covers every input sample.
+*/
+uint8_t AD7794::getResultFlags()
+{
+  return resultFlags;
 }
 
+/* scanEvery - Duty-cycled scanning for battery powered loggers. Once every
+   intervalMs it wakes the chip, scans every enabled channel into buf
+   (channel order, as readScan()) and puts it back in power-down; otherwise
+   it returns false right away. The chip keeps its registers in power-down,
+   so waking is just the first conversion's mode write, in the same transfer
+   as the conf write if the channel differs: no reset, delay or throw-away
+   read as in begin(). The first result comes one settling time after that
+   (getWakeLatency()). getScanCharge() estimates the charge drawn while
+   awake from the time each channel took and its gain and buffer setting.
+   Setters called between scans keep the chip powered down. If a channel
+   times out the chip is powered down and it returns false, with
+   AD7794_Err_Timeout set.
+*/
+bool AD7794::scanEvery(uint32_t intervalMs, uint32_t *buf, uint8_t bufSize)
+{
+  uint32_t now = millis();
+  if(dutyStarted && (now - dutyLastMs) < intervalMs){
+    return false;
+  }
+  //Keep the schedule, unless it fell more than an interval behind
+  dutyLastMs = (dutyStarted && (now - dutyLastMs) < 2 * intervalMs) ? dutyLastMs + intervalMs : now;
+  dutyStarted = true;
 
-//////// Private helper functions/////////////////
+  uint32_t wakeUs = micros();
+  if(!startScan()){
+    return false;
+  }
 
-//This has been changed and is untested
-void AD7794::buildConfReg()
-{  
-  confReg = AD7794_DEFAULT_CONF_REG; //wipe it back to default
+  AD7794_Sample sample;
+  uint32_t lastUs = wakeUs;
+  uint32_t timeouts = timeoutCount;
+  float charge = 0; //uA * us
+  for(uint8_t n = 0; n < scanCount; ){
+    if(timeoutCount != timeouts){
+      enterLowPower(AD7794_OpMode_PowerDown); //Also restores single conversion mode
+      return false;
+    }
+    if(pollScan(sample)){
+      if(n == 0){
+        wakeLatencyUs = sample.timestamp - wakeUs;
+      }
+      charge += (float)(sample.timestamp - lastUs) * channelCurrentUa(sample.channel);
+      lastUs = sample.timestamp;
 
-  confReg = (getGainBits(Channel[currentCh].gain) << 8) | currentCh;  
-  
-  if(Channel[currentCh].vBiasEnabled && (currentCh < 3)){
-    uint8_t biasBits = currentCh + 1; 
-    confReg |= (biasBits << 14);
-    confReg |= (1 << 11); //Lets also set the boost bit
+      uint8_t pos = scanPosition(sample.channel);
+      if(pos < bufSize){
+        buf[pos] = sample.raw;
+      }
+      n++;
+    }
   }
-  
-  confReg |= (!Channel[currentCh].isBipolar << 12);
-  confReg |= (Channel[currentCh].isBuffered << 4);
 
-  //Set reference select bits
-  confReg |= (Channel[currentCh].refMode << 6);   
+  enterLowPower(AD7794_OpMode_PowerDown);
+  scanCharge = charge / 1e6;
+  return true;
+}
 
+/* restoreAfterPowerCycle - Call after switching the chip's supply off and
+   on again. Its registers are back at their power-on values, which the
+   register cache now assumes, so the next conversion start writes the mode
+   and conf registers back in one transfer. Calibration registers are lost
+   too, see restoreCalibration().
+*/
+void AD7794::restoreAfterPowerCycle()
+{
+  chipModeReg = AD7794_POR_MODE_REG;
+  chipConfReg = AD7794_POR_CONF_REG;
+  shadowValid = true;
+  contConvStarted = false;
+  lowPowerMode = 0;
 }
 
-void AD7794::writeConfReg()
+uint32_t AD7794::getWakeLatency()
+{
+  return wakeLatencyUs;
+}
+
+float AD7794::getScanCharge()
+{
+  return scanCharge;
+}
+
+/* readBurst - Selects ch once and takes n back to back results in continuous
+   conversion mode, so only the first one waits for the settling time and
+   there is one configuration write in all. Mean, standard deviation and
+   peak to peak are kept as the results come in; the median and trimmed
+   mean also keep the results sorted, so for those n can be at most
+   AD7794_BURST_MAX. After the first result the next one is due exactly one
+   conversion period later, so each takes a single status check. Single
+   conversion mode is restored afterwards. Returns false on a timeout or a
+   bad argument.
+*/
+bool AD7794::readBurst(uint8_t ch, uint16_t n, AD7794_BurstMode mode, AD7794_BurstResult &result)
+{
+  if(ch >= AD7794_CHANNEL_COUNT || n == 0 || irqActive || streamActive){
+    return false;
+  }
+  if(mode != AD7794_Burst_Mean && n > AD7794_BURST_MAX){
+    return false;
+  }
+  if(scanActive){
+    stopScan();
+  }
+
+  bool restoreSingle = isSnglConvMode;
+  if(isSnglConvMode){
+    isSnglConvMode = false;
+    modeReg &= 0x1FFF; //MD2..MD0 = 000, continuous, goes out with the channel select
+    contConvStarted = false;
+  }
+
+  uint32_t sorted[AD7794_BURST_MAX];
+  uint32_t first = 0, lo = 0, hi = 0;
+  int64_t sum = 0;
+  float mean = 0, m2 = 0;
+  uint8_t flags = 0;
+  uint32_t readAt = 0;
+  uint16_t i;
+
+  for(i = 0; i < n; i++){
+    if(i == 0){
+      startReading(ch);
+    }
+    else{
+      //Already converting on ch. RDY went low at most one poll before the
+      //last result was read, so the next one is ready a period after that
+      acqState = AD7794_Acq_Converting;
+      acqReadyAt = readAt + convPeriodUs();
+      acqStartTime = millis();
+    }
+    if(waitForConvReady(convTimeout) != 0){
+      acqState = AD7794_Acq_Idle;
+      break;
+    }
+    readAt = micros();
+    flags |= resultFlags;
+    uint32_t raw = getResultRaw();
+
+    //Relative to the first result, so the float Welford terms stay small
+    if(i == 0){
+      first = lo = hi = raw;
+    }
+    int32_t d = (int32_t)(raw - first);
+    sum += d;
+    float delta = d - mean;
+    mean += delta / (i + 1);
+    m2 += delta * (d - mean);
+    if(raw < lo) lo = raw;
+    if(raw > hi) hi = raw;
+
+    if(mode != AD7794_Burst_Mean){
+      uint16_t j = i;
+      for(; j > 0 && sorted[j - 1] > raw; j--){
+        sorted[j] = sorted[j - 1];
+      }
+      sorted[j] = raw;
+    }
+  }
+
+  if(restoreSingle){
+    setMode(AD7794_OpMode_SingleConv);
+  }
+  if(i < n){
+    return false;
+  }
+
+  if(mode == AD7794_Burst_Median){
+    result.raw = (n & 1) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2] + 1) / 2;
+  }
+  else if(mode == AD7794_Burst_TrimmedMean){
+    uint16_t trim = n / 4;
+    int64_t s = 0;
+    for(uint16_t j = trim; j < n - trim; j++){
+      s += (int32_t)(sorted[j] - first);
+    }
+    uint16_t kept = n - 2 * trim;
+    result.raw = first + (int32_t)((s + (s < 0 ? -(int64_t)kept : kept) / 2) / kept);
+  }
+  else{
+    result.raw = first + (int32_t)((sum + (sum < 0 ? -(int64_t)n : n) / 2) / n);
+  }
+  result.stdDev = n > 1 ? sqrt(m2 / (n - 1)) : 0;
+  result.peakToPeak = hi - lo;
+  result.count = n;
+  result.flags = flags;
+  return true;
+}
+
+/* startContinuousIRQ - Puts the chip in continuous conversion mode on one
+   channel and harvests every result from the falling edge of DOUT/RDY into
+   the queue. CS stays asserted (RDY only shows on DOUT while it is) and the
+   SPI transaction stays open until stopContinuousIRQ().
+*/
+bool AD7794::startContinuousIRQ(uint8_t ch, uint8_t pin, AD7794_SampleQueue &queue)
+{
+  if(scanActive){
+    stopScan();
+  }
+  if(irqActive || streamActive || ch >= AD7794_CHANNEL_COUNT || digitalPinToInterrupt(pin) == NOT_AN_INTERRUPT){
+    return false;
+  }
+
+  uint8_t slot = 0;
+  while(slot < AD7794_MAX_IRQ_INSTANCES && irqOwners[slot] != NULL){
+    slot++;
+  }
+  if(slot == AD7794_MAX_IRQ_INSTANCES){
+    return false;
+  }
+
+  irqRestoreSingle = isSnglConvMode;
+  isSnglConvMode = false;
+  modeReg &= 0x1FFF; //MD2..MD0 = 000, continuous
+  acqState = AD7794_Acq_Idle;
+
+  setActiveCh(ch);
+
+  if(pin != MISO){
+    pinMode(pin, INPUT);
+  }
+  drdyPin = pin;
+  irqQueue = &queue;
+  irqSlot = slot;
+  lastIrqTime = 0;
+  irqOverruns = 0;
+  irqOwners[slot] = this;
+
+  if(configBatch){
+    commit();
+  }
+
+  bus->beginTransaction(spiSettings);
+  digitalWrite(CS,LOW);
+  transferModeReg(modeReg);
+
+  irqActive = true;
+
+  static void (*const isrTable[AD7794_MAX_IRQ_INSTANCES])() = {
+    drdyIsr<0>, drdyIsr<1>, drdyIsr<2>, drdyIsr<3>
+  };
+  attachInterrupt(digitalPinToInterrupt(pin), isrTable[slot], FALLING);
+
+  return true;
+}
+
+void AD7794::stopContinuousIRQ()
+{
+  if(!irqActive){
+    return;
+  }
+
+  detachInterrupt(digitalPinToInterrupt(drdyPin));
+  irqOwners[irqSlot] = NULL;
+  irqActive = false;
+
+  endContinuous(irqRestoreSingle);
+}
+
+//Releases CS and the bus after streaming, and puts back single conversion
+//mode if that is what was in use before
+void AD7794::endContinuous(bool restoreSingle)
+{
+  digitalWrite(CS,HIGH);
+  bus->endTransaction();
+
+  contConvStarted = false;
+  if(restoreSingle){
+    setMode(AD7794_OpMode_SingleConv);
+  }
+}
+
+bool AD7794::isStreamingIRQ()
+{
+  return irqActive;
+}
+
+/* overrunCount - Conversions that completed but were never harvested
+   because the interrupt was serviced too late (estimated from timestamps)
+*/
+uint32_t AD7794::overrunCount()
+{
+  noInterrupts();
+  uint32_t n = irqOverruns;
+  interrupts();
+  return n;
+}
+
+template <uint8_t N>
+void AD7794_ISR_ATTR AD7794::drdyIsr()
+{
+  if(irqOwners[N] != NULL){
+    irqOwners[N]->handleDrdy();
+  }
+}
+
+void AD7794_ISR_ATTR AD7794::handleDrdy()
+{
+  //DOUT also toggles while data is clocked out, and those edges end up
+  //here too. Only DOUT held low between transfers is a new result.
+  if(digitalRead(drdyPin) != LOW){
+    return;
+  }
+
+  AD7794_Sample sample;
+  sample.raw = getConvResult();
+  sample.timestamp = micros();
+  sample.channel = currentCh;
+  sample.flags = 0;
+  sample.gain = 1 << Channel[currentCh].gainBits;
+  bool emit = filterSample(currentCh, sample.raw);
+
+  if(lastIrqTime != 0){
+    uint32_t period = convPeriodUs();
+    uint32_t dt = sample.timestamp - lastIrqTime;
+    if(dt > period + period / 2){
+      irqOverruns += (dt + period / 2) / period - 1;
+    }
+  }
+  lastIrqTime = sample.timestamp;
+
+  if(emit){
+    irqQueue->push(sample);
+    AD7794_STAT(stats.samples++);
+  }
+}
+
+/* startStreaming - Continuous conversion with continuous read (CREAD) on one
+   channel. After the CREAD command the chip puts each new result on DOUT as
+   soon as it is clocked, so a sample costs 24 SCLKs and no command byte.
+   RDY is watched on drdyPin (DOUT/RDY, MISO by default).
+*/
+bool AD7794::startStreaming(uint8_t ch, uint8_t pin)
+{
+  if(scanActive){
+    stopScan();
+  }
+  if(irqActive || streamActive || ch >= AD7794_CHANNEL_COUNT){
+    return false;
+  }
+
+  if(configBatch){
+    commit();
+  }
+
+  streamRestoreSingle = isSnglConvMode;
+  isSnglConvMode = false;
+  modeReg &= 0x1FFF; //MD2..MD0 = 000, continuous
+  acqState = AD7794_Acq_Idle;
+
+  setActiveCh(ch);
+  drdyPin = pin;
+
+  bus->beginTransaction(spiSettings);
+  digitalWrite(CS,LOW);
+  transferModeReg(modeReg);
+
+  bus->transfer(AD7794_READ_DATA_CONT);
+  AD7794_STAT(stats.configBytes += 1);
+  streamActive = true;
+
+  return true;
+}
+
+/* readStream - Fills buf with the next count results. Returns how many were
+   read, which is less than count if RDY didn't come within the timeout.
+*/
+uint16_t AD7794::readStream(uint32_t *buf, uint16_t count)
+{
+  if(!streamActive){
+    return 0;
+  }
+
+  for(uint16_t i = 0; i < count; ){
+    if(!waitForDoutLow(convTimeout)){
+      setError(AD7794_Err_Timeout);
+      return i;
+    }
+
+    //DIN must stay low in CREAD, the chip is watching it for the exit command
+    uint8_t data[3] = {0x00, 0x00, 0x00};
+    bus->transfer(data, 3);
+    uint32_t result = ((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | data[2];
+    AD7794_STAT(stats.dataBytes += 3);
+    if(filterSample(currentCh, result)){
+      buf[i++] = result;
+      AD7794_STAT(stats.samples++);
+    }
+  }
+  return count;
+}
+
+/* stopStreaming - Clean exit from continuous read. The exit command has to
+   be written while RDY is low, and the result it unlocks is then read out
+   (and thrown away) like a normal data read.
+*/
+void AD7794::stopStreaming()
+{
+  if(!streamActive){
+    return;
+  }
+
+  if(waitForDoutLow(convTimeout)){
+    getConvResult(); //Sends 0x58, which also ends CREAD
+    streamActive = false;
+    endContinuous(streamRestoreSingle);
+  }
+  else{
+    resync();
+  }
+}
+
+/* resync - Gets back in step with the chip when streaming lost sync (or
+   anything else went wrong). Resets the serial interface, which also resets
+   the registers, then writes the mode and conf registers back.
+*/
+void AD7794::resync()
+{
+  if(streamActive || irqActive){
+    if(irqActive){
+      detachInterrupt(digitalPinToInterrupt(drdyPin));
+      irqOwners[irqSlot] = NULL;
+    }
+    digitalWrite(CS,HIGH);
+    bus->endTransaction();
+    if(streamActive ? streamRestoreSingle : irqRestoreSingle){
+      modeReg &= 0x1FFF;
+      modeReg |= (uint16_t)AD7794_OpMode_SingleConv << 13;
+      isSnglConvMode = true;
+    }
+    streamActive = false;
+    irqActive = false;
+  }
+
+  reset();
+  delay(1); //500 us before the serial interface can be used again
+
+  contConvStarted = false;
+  acqState = AD7794_Acq_Idle;
+  writeModeReg();
+  buildConfReg();
+  writeConfReg();
+}
+
+bool AD7794::isStreaming()
+{
+  return streamActive;
+}
+
+//CS must be asserted, DOUT only doubles as RDY while it is
+bool AD7794::waitForDoutLow(uint32_t timeout)
+{
+  uint32_t t = millis();
+
+  while(digitalRead(drdyPin) != LOW){
+    if((millis() - t) > timeout){
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t AD7794::convPeriodUs()
+{
+  return convPeriodUs(modeReg);
+}
+
+//Time from a channel switch (or conversion start) to the first valid result
+uint32_t AD7794::settleTimeUs()
+{
+  return settleTimeUs(modeReg);
+}
+
+uint32_t AD7794::convPeriodUs(uint16_t mode)
+{
+  return pgm_read_dword(&convPeriodTable[mode & 0x0F]);
+}
+
+uint32_t AD7794::settleTimeUs(uint16_t mode)
+{
+  if(mode & 0x0010){
+    return convPeriodUs(mode); //Chop disabled, filter settles in one period
+  }
+  return pgm_read_dword(&settleTimeTable[mode & 0x0F]);
+}
+
+//Mode register bits (rate and chop) that go with a channel
+uint16_t AD7794::channelModeBits(uint8_t ch)
+{
+  return Channel[ch].rateCode | (Channel[ch].chopEnabled ? 0 : AD7794_CHOP_DISABLE);
+}
+
+//Puts a channel's rate and chop setting in the mode register image.
+//Returns true if that changed it.
+bool AD7794::loadChannelMode(uint8_t ch)
+{
+  uint16_t mode = (modeReg & ~AD7794_CHANNEL_MODE_BITS) | channelModeBits(ch);
+
+  if(mode == modeReg){
+    return false;
+  }
+  modeReg = mode;
+  updateTimeout();
+  return true;
+}
+
+//A conversion that takes 1.5x its settling time (plus a tick of millis()
+//slack) is not coming. Fails a stuck chip in 7 ms at 470 Hz instead of
+//waiting half a second.
+void AD7794::updateTimeout()
+{
+  uint32_t us = settleTimeUs();
+  convTimeout = (us + us / 2 + 999) / 1000 + 1;
+}
+
+uint16_t AD7794::getTimeout()
+{
+  return convTimeout;
+}
+
+void AD7794::setError(AD7794_Error err)
+{
+  lastError = err;
+  if(err == AD7794_Err_Timeout){
+    timeoutCount++;
+    AD7794_STAT(stats.timeouts++);
+  }
+}
+
+#ifdef AD7794_ENABLE_STATS
+const AD7794_Stats &AD7794::getStats()
+{
+  return stats;
+}
+
+void AD7794::resetStats()
+{
+  memset(&stats, 0, sizeof(stats));
+}
+
+//Counts a delivered result and files its wait (start to ready) in the
+//channel's histogram, bucket n covers 2^(n-1) to 2^n ms
+void AD7794::recordWait(uint8_t ch, uint32_t startUs)
+{
+  uint32_t waitUs = micros() - startUs;
+  uint32_t ms = waitUs / 1000;
+  uint8_t bucket = 0;
+
+  while(ms > 0 && bucket < AD7794_STATS_BUCKETS - 1){
+    ms >>= 1;
+    bucket++;
+  }
+
+  stats.samples++;
+  if(waitUs > stats.maxWaitUs){
+    stats.maxWaitUs = waitUs;
+  }
+  if(stats.waitHist[ch][bucket] < 0xFFFF){
+    stats.waitHist[ch][bucket]++;
+  }
+}
+#endif
+
+/* getLastError - Returns the most recent error and clears it */
+AD7794_Error AD7794::getLastError()
+{
+  AD7794_Error err = lastError;
+  lastError = AD7794_Err_None;
+  return err;
+}
+
+uint32_t AD7794::getTimeoutCount()
+{
+  return timeoutCount;
+}
+
+uint32_t AD7794::getStatusReads()
+{
+  return statusReads;
+}
+
+uint32_t AD7794::getRejectedCount()
+{
+  return rejectedCount;
+}
+
+/* startScan - Cycles through every enabled channel in continuous conversion
+   mode. As soon as a result is read the conf reg is rewritten for the next
+   channel, in the same transaction, so the chip is already converting it
+   while the caller handles the sample. Writing the conf reg resets the
+   digital filter and RDY is held off until the new channel has settled
+   (tSETTLE, 2/fADC with chop, 1/fADC without), so nothing has to be thrown
+   away after a switch. setScanDiscards() adds extra discards for slow
+   external circuits (e.g. a multiplexer or excitation that needs time).
+*/
+bool AD7794::startScan()
+{
+  if(irqActive || streamActive){
+    return false;
+  }
+  if(configBatch){
+    commit();
+  }
+
+  //Channels that share a rate and chop setting are scanned back to back,
+  //so the mode register only changes once per group
+  scanCount = 0;
+  for(uint8_t i = 0; i < AD7794_CHANNEL_COUNT; i++){
+    if(Channel[i].isEnabled){
+      uint8_t pos = scanCount;
+      for(uint8_t j = 0; j < scanCount; j++){
+        if(channelModeBits(scanList[j]) == channelModeBits(i)){
+          pos = j + 1;
+        }
+      }
+      for(uint8_t j = scanCount; j > pos; j--){
+        scanList[j] = scanList[j - 1];
+      }
+      scanList[pos] = i;
+      scanCount++;
+    }
+  }
+  if(scanCount == 0){
+    return false;
+  }
+
+  if(!scanActive){
+    scanRestoreSingle = isSnglConvMode;
+  }
+  isSnglConvMode = false;
+  modeReg &= 0x1FFF; //MD2..MD0 = 000, continuous
+  acqState = AD7794_Acq_Idle;
+
+  scanIdx = 0;
+  resultFlags = 0;
+  startConv(scanList[0]);
+  contConvStarted = true;
+
+  scanDiscardsLeft = scanDiscards;
+  rejectRun = 0;
+  scanWaitStart = millis();
+  scanReadyAt = micros() + settleTimeUs();
+  AD7794_STAT(scanStartUs = micros());
+  scanActive = true;
+  return true;
+}
+
+/* pollScan - One short status transaction. Returns true and fills sample
+   when a result for the current scan channel was ready. The channel bits of
+   the status byte must match the scan channel, otherwise the result is
+   dropped and the channel selected again; the ERR bit ends up in flags.
+*/
+bool AD7794::pollScan(AD7794_Sample &sample)
+{
+  if(!scanActive){
+    return false;
+  }
+
+  bool gotSample = false;
+
+  if((int32_t)(micros() - scanReadyAt) < 0){
+    return false; //Channel still settling, leave the bus alone
+  }
+
+  bus->beginTransaction(spiSettings);
+  digitalWrite(CS,LOW);
+  statusReads++;
+
+  uint8_t status = readStatusReg();
+  uint8_t ch = scanList[scanIdx];
+
+  if((status & AD7794_STATUS_RDY) == 0 && !checkResultChannel(status, ch)){
+    scanDiscardsLeft = scanDiscards;
+    scanReadyAt = micros() + settleTimeUs();
+    if(++rejectRun <= AD7794_REJECT_RETRIES){
+      scanWaitStart = millis(); //Bounded, as in poll()
+    }
+  }
+  else if((status & AD7794_STATUS_RDY) == 0){
+    AD7794_Filter *f = Channel[ch].filter;
+    rejectRun = 0;
+    uint8_t gainBits = (chipConfReg >> 8) & 0x07; //Gain the result was converted with
+    uint32_t raw;
+
+    if(status & AD7794_STATUS_ERR){
+      resultFlags |= AD7794_FLAG_RANGE;
+    }
+
+    //When this result is sure to be used, the next channel is selected in
+    //the same bulk transfer as the data read
+    if(scanCount > 1 && scanDiscardsLeft == 0 && (f == nullptr || f->getRatio() == 1)){
+      scanIdx = (scanIdx + 1) % scanCount;
+      raw = readDataAndSelect(scanList[scanIdx]);
+      trackRange(ch, gainBits, raw, status);
+      filterSample(ch, raw);
+
+      sample.raw = raw;
+      sample.channel = ch;
+      sample.timestamp = micros();
+      sample.flags = resultFlags;
+      sample.gain = 1 << Channel[ch].gainBits;
+      resultFlags = 0;
+      gotSample = true;
+      AD7794_STAT(recordWait(ch, scanStartUs); scanStartUs = sample.timestamp);
+
+      scanDiscardsLeft = scanDiscards;
+      scanReadyAt = micros() + settleTimeUs();
+    }
+    else{
+      raw = getConvResult();
+      trackRange(ch, gainBits, raw, status);
+      scanReadyAt = micros() + convPeriodUs() - convPeriodUs() / 8;
+
+      if(scanDiscardsLeft > 0){
+        scanDiscardsLeft--;
+        resultFlags = 0;
+      }
+      else if(!filterSample(ch, raw)){
+        //Decimating, stay on this channel for the next conversion
+      }
+      else{
+        sample.raw = raw;
+        sample.channel = ch;
+        sample.timestamp = micros();
+        sample.flags = resultFlags;
+        sample.gain = 1 << Channel[ch].gainBits;
+        resultFlags = 0;
+        gotSample = true;
+        AD7794_STAT(recordWait(ch, scanStartUs); scanStartUs = sample.timestamp);
+
+        //Switch to the next channel straight away
+        if(scanCount > 1){
+          scanIdx = (scanIdx + 1) % scanCount;
+          currentCh = scanList[scanIdx];
+          buildConfReg();
+          transferConfReg();
+          if(loadChannelMode(currentCh)){
+            transferModeReg(modeReg); //Rate or chop changes with the channel
+          }
+          scanDiscardsLeft = scanDiscards;
+          scanReadyAt = micros() + settleTimeUs();
+        }
+        else if(rangePending(ch)){
+          //Only channel, nothing else writes its conf reg
+          buildConfReg();
+          transferConfReg();
+          scanDiscardsLeft = scanDiscards;
+          scanReadyAt = micros() + settleTimeUs();
+        }
+      }
+    }
+    scanWaitStart = millis();
+  }
+
+  digitalWrite(CS,HIGH);
+  bus->endTransaction();
+
+  if(!gotSample && (millis() - scanWaitStart) > convTimeout){
+    setError(AD7794_Err_Timeout);
+    startScan(); //Chip stopped converting, start over
+  }
+
+  return gotSample;
+}
+
+/* readScan - Blocking, one full pass over the scan list. Results are put in
+   buf in channel order (the same order as read(buf,size)). Returns the number
+   of enabled channels. If the chip stops delivering (a conversion timeout in
+   pollScan()) it returns the results collected so far, with
+   AD7794_Err_Timeout set; the other entries of buf are left as they were.
+*/
+uint8_t AD7794::readScan(uint32_t *buf, uint8_t bufSize)
+{
+  if(!scanActive && !startScan()){
+    return 0;
+  }
+
+  AD7794_Sample sample;
+  uint32_t timeouts = timeoutCount;
+  for(uint8_t n = 0; n < scanCount; ){
+    if(pollScan(sample)){
+      uint8_t pos = scanPosition(sample.channel);
+      if(pos < bufSize){
+        buf[pos] = sample.raw;
+      }
+      n++;
+    }
+    else if(timeoutCount != timeouts){
+      return n;
+    }
+  }
+  return scanCount;
+}
+
+void AD7794::stopScan()
+{
+  if(!scanActive){
+    return;
+  }
+  scanActive = false;
+  contConvStarted = false;
+  if(scanRestoreSingle){
+    setMode(AD7794_OpMode_SingleConv);
+  }
+}
+
+bool AD7794::isScanning()
+{
+  return scanActive;
+}
+
+/* getScanWait - How long pollScan() would leave the bus alone, so a task
+   can sleep instead of polling. 0 when a result may be ready.
+*/
+uint32_t AD7794::getScanWait()
+{
+  int32_t wait = (int32_t)(scanReadyAt - micros());
+  return (scanActive && wait > 0) ? wait : 0;
+}
+
+/* setScanDiscards - Extra conversions to throw away after each channel
+   switch, on top of the settling the chip already does. Default 0.
+*/
+void AD7794::setScanDiscards(uint8_t count)
+{
+  scanDiscards = count;
+}
+
+/* getScanRate - Effective sample rate per channel (Hz) with the current
+   set of enabled channels, update rate and chop setting
+*/
+float AD7794::getScanRate()
+{
+  uint8_t n = scanPosition(AD7794_CHANNEL_COUNT);
+
+  if(n == 0){
+    return 0;
+  }
+  uint32_t perPass = 0;
+  for(uint8_t i = 0; i < AD7794_CHANNEL_COUNT; i++){
+    if(Channel[i].isEnabled){
+      uint16_t ratio = (Channel[i].filter != nullptr) ? Channel[i].filter->getRatio() : 1;
+      uint16_t mode = channelModeBits(i);
+      if(n == 1){
+        return 1e6 / ((float)convPeriodUs(mode) * ratio); //No switching, full update rate
+      }
+      perPass += settleTimeUs(mode) + (uint32_t)(scanDiscards + ratio - 1) * convPeriodUs(mode);
+    }
+  }
+  return 1e6 / (float)perPass;
+}
+
+//Position of a channel in read(buf,size) order (enabled channels, ascending)
+uint8_t AD7794::scanPosition(uint8_t ch)
+{
+  uint8_t pos = 0;
+  for(uint8_t i = 0; i < ch; i++){
+    if(Channel[i].isEnabled){
+      pos++;
+    }
+  }
+  return pos;
+}
+
+//Experiment with reading all active channels. In continuous conversion mode
+//this uses the scan engine, so switching channels costs no extra round trips.
+//Channels that timed out read NAN, like read(ch).
+void AD7794::read(float *buf, uint8_t bufSize)
+{
+  uint8_t readingCnt = 0 ;
+
+  if(!isSnglConvMode || scanActive){
+    uint32_t raw[AD7794_CHANNEL_COUNT];
+    for(uint8_t i = 0; i < AD7794_CHANNEL_COUNT; i++){
+      raw[i] = AD7794_READ_ERROR; //readScan() leaves missing results alone
+    }
+    readScan(raw, AD7794_CHANNEL_COUNT);
+
+    for(uint8_t i = 0; i < AD7794_CHANNEL_COUNT; i++){
+      if(Channel[i].isEnabled){
+        if(readingCnt < bufSize){
+          buf[readingCnt] = raw[readingCnt] == AD7794_READ_ERROR ? NAN : rawToVolts(i, raw[readingCnt]);
+        }
+        readingCnt++;
+      }
+    }
+    return;
+  }
+
+  for(int i = 0;  i < AD7794_CHANNEL_COUNT; i++){
+    if(Channel[i].isEnabled){
+      if(readingCnt < bufSize){
+        buf[readingCnt] = read(i);
+      }else{
+        //buffer too small!
+        //Maybe return an error code?
+      }
+      readingCnt++;
+    }
+  }
+}
+
+/* read - The single channel version
+   Gets reading from a single channel. Right now it
+   is in volts (default scailing), but I may have it use
+   a scaling setting stored for each channel. I might also
+   just save that for a higher level hardware abstraction class.
+*/
+float AD7794::read(uint8_t ch)
+{
+  //Lets the conversion result
+  uint32_t adcRaw = getReadingRaw(ch);
+  //Serial.print(adcRaw);
+  //Serial.print(' ');
+
+  if(adcRaw == AD7794_READ_ERROR){
+    return NAN; //Timed out, see getLastError()
+  }
+
+  return rawToVolts(ch, adcRaw);
+}
+
+float AD7794::rawToVolts(uint8_t ch, uint32_t adcRaw)
+{
+  float result;
+
+  if(ch == 6){ //Channel 6 is temperature, handle it differently due to 1.17 V internal Ref
+    //return (((float)adcRaw / AD7794_ADC_MAX_BP - 1) * 1.17)*100; //Bipolar, not sure what mode for temp sensor
+    return TempSensorRawToDegC(adcRaw);    
+  }
+
+  //And convert to Volts, note: no error checking
+  uint8_t gain = 1 << Channel[ch].gainBits;
+  if(!Channel[ch].isBipolar){
+    result = (adcRaw * refVolts(ch)) / (AD7794_ADC_MAX_UP * gain);            //Unipolar formula
+    //Serial.print("unipolar");
+  }
+  else{
+    result = (((float)adcRaw / AD7794_ADC_MAX_BP - 1) * refVolts(ch)) / gain; //Bipolar formula    
+    //Serial.print("bipolar");
+  }
+
+  return result - offset(ch);
+}
+
+/* toFixed - Integer only conversion of a raw code to microvolts, with
+   AD7794_FIXED_FRAC_BITS fraction bits (+/-8.3 V range with the default 8).
+   Uses the factors from scaleOf(), so there is no division and no floating
+   point. Channel 6 gives the temperature sensor
+   voltage, not degrees.
+*/
+int32_t AD7794::toFixed(uint8_t ch, uint32_t adcRaw)
+{
+  const AD7794_Scale s = scaleOf(ch);
+  return (int32_t)(((int64_t)((int32_t)adcRaw - s.zero) * s.mult) >> s.shift) - s.offset;
+}
+
+/* convert - toFixed() for a whole buffer of raw codes from one channel */
+void AD7794::convert(uint8_t ch, const uint32_t *raw, int32_t *out, uint16_t count)
+{
+  const AD7794_Scale s = scaleOf(ch);
+
+  for(uint16_t i = 0; i < count; i++){
+    out[i] = (int32_t)(((int64_t)((int32_t)raw[i] - s.zero) * s.mult) >> s.shift) - s.offset;
+  }
+}
+
+int32_t AD7794::readFixed(uint8_t ch)
+{
+  uint32_t adcRaw = getReadingRaw(ch);
+
+  if(adcRaw == AD7794_READ_ERROR){
+    return AD7794_FIXED_ERROR;
+  }
+  return toFixed(ch, adcRaw);
+}
+
+AD7794_Scale AD7794::getScale(uint8_t ch)
+{
+  return scaleOf(ch < AD7794_CHANNEL_COUNT ? ch : 0);
+}
+
+/* Convert AD7794X on-chip temp sensor readings to Deg C */
+float AD7794::TempSensorRawToDegC(uint32_t rawData)  {
+        float volts = ((float)rawData - 0x800000) * (AD7794_INTERNAL_REF_V / AD7794_ADC_MAX_BP);
+        float degK = volts/0.00081; //Sensitivity = 0.81 mv/DegC
+        float degC = degK - 273;                
+        return(degC);
+}
+
+/* zero - Record offsets to apply to the channel (if active) */
+void AD7794::zero(uint8_t ch)
 {  
-  SPI.beginTransaction(spiSettings);
+  
+  if(Channel[ch].isEnabled == true){
+    //read(ch); //Take a throw away reading first -This is now done in begin,shouldn't be needed here anymore
+    
+    Channel[ch].offset = 0; //Measure from scratch, not on top of the old offset
+    float volts = read(ch);
+    if(!isnan(volts)){
+      Channel[ch].offset = (int32_t)(volts * AD7794_FIXED_PER_VOLT + (volts < 0 ? -0.5 : 0.5));
+    }
+  }
+}
+
+/* zero - Record offsets to apply to all active
+   channels. (NOT temperature an AVDD monitor)
+*/
+void AD7794::zero()
+{ 
+  for(int i = 0;  i < AD7794_CHANNEL_COUNT-2 ; i++){
+    zero(i);
+  }
+}
+
+/* offset - Returns channel offset value. I'm not sure if this will be needed
+   in the long run, but it's usefull for testing now.
+*/
+float AD7794::offset(uint8_t ch)
+{
+  return Channel[ch].offset * (float)(1 / AD7794_FIXED_PER_VOLT);
+}
+
+/* calibrate - Runs one of the chip's calibration modes on a channel, at the
+   gain and polarity it is set to now. For the system calibrations the zero
+   or full-scale input has to be applied to the channel first. The result
+   ends up in the channel's offset or full-scale register, which the chip
+   applies to every conversion from then on. Blocks until the chip is done
+   (1 or 2 settling times). The chip is idle afterwards, the next reading
+   restarts conversions as usual.
+*/
+bool AD7794::calibrate(uint8_t ch, AD7794_OperatingModes calMode)
+{
+  if(ch >= AD7794_CAL_CHANNEL_COUNT || calMode < AD7794_OpMode_InternalZeroCalibration){
+    return false;
+  }
+  if(calMode == AD7794_OpMode_InternalFsCalibration && Channel[ch].gainBits == 7){
+    return false; //Not supported by the chip at gain 128
+  }
+  if(irqActive || streamActive){
+    return false;
+  }
+  if(configBatch){
+    commit();
+  }
+  if(scanActive){
+    stopScan();
+  }
+
+  setActiveCh(ch);
+
+  uint16_t calReg = (modeReg & 0x1FFF) | ((uint16_t)calMode << 13);
+
+  bus->beginTransaction(spiSettings);
+  digitalWrite(CS,LOW);
+  transferModeReg(calReg);
+  digitalWrite(CS,HIGH);
+  bus->endTransaction();
+
+  //The chip drops to idle mode when it is done
+  chipModeReg = (modeReg & 0x1FFF) | ((uint16_t)2 << 13);
+  contConvStarted = false;
+  acqState = AD7794_Acq_Idle;
+
+  //Zero-scale takes one settling time, full-scale two
+  uint8_t steps = (calMode == AD7794_OpMode_InternalFsCalibration ||
+                   calMode == AD7794_OpMode_SystemFsCalibration) ? 2 : 1;
+  uint32_t timeout = steps * convTimeout;
+  uint32_t start = millis();
+  uint32_t readyAt = micros() + steps * settleTimeUs();
+  bool done = false;
+
+  while((int32_t)(micros() - readyAt) < 0){
+    yield();
+  }
+
+  while(!done){
+    bus->beginTransaction(spiSettings);
+    digitalWrite(CS,LOW);
+    statusReads++;
+    done = (readStatusReg() & 0x80) == 0;
+    digitalWrite(CS,HIGH);
+    bus->endTransaction();
+
+    if(!done && (millis() - start) > timeout){
+      setError(AD7794_Err_Timeout);
+      return false;
+    }
+    if(!done){
+      delayMicroseconds(convPeriodUs() / 32);
+    }
+  }
+  return true;
+}
+
+/* calibrate - Internal zero-scale then internal full-scale calibration of a
+   channel. The full-scale step is skipped at gain 128, where the chip can't
+   do it.
+*/
+bool AD7794::calibrate(uint8_t ch)
+{
+  if(!calibrate(ch, AD7794_OpMode_InternalZeroCalibration)){
+    return false;
+  }
+  if(Channel[ch].gainBits == 7){
+    return true;
+  }
+  return calibrate(ch, AD7794_OpMode_InternalFsCalibration);
+}
+
+uint32_t AD7794::getOffsetReg(uint8_t ch)
+{
+  return readReg24(ch, AD7794_READ_OFFSET_REG);
+}
+
+uint32_t AD7794::getFullScaleReg(uint8_t ch)
+{
+  return readReg24(ch, AD7794_READ_FS_REG);
+}
+
+void AD7794::setOffsetReg(uint8_t ch, uint32_t value)
+{
+  writeReg24(ch, AD7794_WRITE_OFFSET_REG, value);
+}
+
+void AD7794::setFullScaleReg(uint8_t ch, uint32_t value)
+{
+  writeReg24(ch, AD7794_WRITE_FS_REG, value);
+}
+
+//CRC-8 (polynomial 0x07) over a stored calibration record
+static uint8_t calCrc8(const uint8_t *buf, uint8_t len)
+{
+  uint8_t crc = 0;
+  for(uint8_t i = 0; i < len; i++){
+    crc ^= buf[i];
+    for(uint8_t b = 0; b < 8; b++){
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+/* saveCalibration - Reads back the offset and full-scale registers of every
+   enabled external channel and stores them, keyed by channel and gain.
+   A record for the same channel and gain is overwritten, so the table can
+   hold one set of coefficients per gain. Returns false if the storage
+   failed or the table is full.
+*/
+bool AD7794::saveCalibration(AD7794_CalStorage &storage)
+{
+  uint8_t header[AD7794_CAL_HEADER_SIZE];
+  uint8_t rec[AD7794_CAL_RECORD_SIZE];
+  uint8_t count = 0;
+  uint8_t prevCh = currentCh;
+  bool ok = true;
+
+  if(storage.read(0, header, sizeof(header)) &&
+     header[0] == highByte(AD7794_CAL_MAGIC) && header[1] == lowByte(AD7794_CAL_MAGIC) &&
+     header[2] == AD7794_CAL_VERSION && header[3] <= AD7794_CAL_MAX_RECORDS){
+    count = header[3];
+  }
+
+  for(uint8_t ch = 0; ch < AD7794_CAL_CHANNEL_COUNT && ok; ch++){
+    if(!Channel[ch].isEnabled){
+      continue;
+    }
+
+    uint32_t offsetReg = getOffsetReg(ch);
+    uint32_t fsReg = getFullScaleReg(ch);
+
+    //Find the slot for this channel and gain, or append
+    uint8_t slot = count;
+    for(uint8_t i = 0; i < count; i++){
+      if(storage.read(AD7794_CAL_HEADER_SIZE + i * AD7794_CAL_RECORD_SIZE, rec, 2) &&
+         rec[0] == ch && rec[1] == getGain(ch)){
+        slot = i;
+        break;
+      }
+    }
+    if(slot >= AD7794_CAL_MAX_RECORDS){
+      ok = false;
+      break;
+    }
+
+    rec[0] = ch;
+    rec[1] = getGain(ch);
+    rec[2] = (offsetReg >> 16) & 0xFF;
+    rec[3] = (offsetReg >> 8) & 0xFF;
+    rec[4] = offsetReg & 0xFF;
+    rec[5] = (fsReg >> 16) & 0xFF;
+    rec[6] = (fsReg >> 8) & 0xFF;
+    rec[7] = fsReg & 0xFF;
+    rec[8] = calCrc8(rec, AD7794_CAL_RECORD_SIZE - 1);
+
+    ok = storage.write(AD7794_CAL_HEADER_SIZE + slot * AD7794_CAL_RECORD_SIZE, rec, sizeof(rec));
+    if(slot == count){
+      count++;
+    }
+  }
+
+  //Header last, so an interrupted save never exposes a half written record
+  header[0] = highByte(AD7794_CAL_MAGIC);
+  header[1] = lowByte(AD7794_CAL_MAGIC);
+  header[2] = AD7794_CAL_VERSION;
+  header[3] = count;
+  ok = storage.write(0, header, sizeof(header)) && ok;
+
+  setActiveCh(prevCh);
+  return ok;
+}
+
+/* restoreCalibration - Writes stored coefficients back to the chip for every
+   external channel whose current gain has a record. Takes a couple of
+   register writes per channel instead of running the calibrations again.
+   Returns the number of channels restored.
+*/
+uint8_t AD7794::restoreCalibration(AD7794_CalStorage &storage)
+{
+  uint8_t header[AD7794_CAL_HEADER_SIZE];
+  uint8_t rec[AD7794_CAL_RECORD_SIZE];
+  uint8_t prevCh = currentCh;
+  uint8_t restored = 0;
+
+  if(!storage.read(0, header, sizeof(header)) ||
+     header[0] != highByte(AD7794_CAL_MAGIC) || header[1] != lowByte(AD7794_CAL_MAGIC) ||
+     header[2] != AD7794_CAL_VERSION || header[3] > AD7794_CAL_MAX_RECORDS){
+    return 0;
+  }
+
+  for(uint8_t i = 0; i < header[3]; i++){
+    if(!storage.read(AD7794_CAL_HEADER_SIZE + i * AD7794_CAL_RECORD_SIZE, rec, sizeof(rec)) ||
+       calCrc8(rec, AD7794_CAL_RECORD_SIZE - 1) != rec[8]){
+      continue;
+    }
+
+    uint8_t ch = rec[0];
+    if(ch >= AD7794_CAL_CHANNEL_COUNT || rec[1] != getGain(ch)){
+      continue;
+    }
+
+    setOffsetReg(ch, ((uint32_t)rec[2] << 16) | ((uint32_t)rec[3] << 8) | rec[4]);
+    setFullScaleReg(ch, ((uint32_t)rec[5] << 16) | ((uint32_t)rec[6] << 8) | rec[7]);
+    restored++;
+  }
+
+  setActiveCh(prevCh);
+  return restored;
+}
+
+//Added 11-14-2021
+//Blocks until the reading started by startReading() is done, or timeout ms
+//Sleeps (yield) until the result is due, then checks RDY at a bounded rate,
+//a few dozen times per conversion period, instead of back to back.
+int AD7794::waitForConvReady (uint32_t timeout){
+
+  uint32_t pollGap = convPeriodUs() / 32;
+  if(pollGap < 20){
+    pollGap = 20;
+  }
+
+  while((int32_t)(micros() - acqReadyAt) < 0){
+    yield();
+  }
+
+  while(poll() == AD7794_Acq_Converting){
+    if((millis() - acqStartTime) > timeout){
+      acqState = AD7794_Acq_Timeout;
+      setError(AD7794_Err_Timeout);
+      break;
+    }
+    delayMicroseconds(pollGap);
+  }
+
+  return (acqState == AD7794_Acq_Ready) ? 0 : -1;
+}
+
+// This function is BLOCKING, it is built on the non-blocking startReading()
+// and poll(), so the bus is only held for each short status check.
+uint32_t AD7794::getReadingRaw(uint8_t ch)
+{
+  if(!startReading(ch)){
+    return AD7794_READ_ERROR;
+  }
+
+  if(waitForConvReady(convTimeout) != 0){
+    acqState = AD7794_Acq_Idle;
+    return AD7794_READ_ERROR;
+  }
+
+  return getResultRaw();
+}
+
+//Selects a channel. Its rate and chop setting go into the mode register,
+//which is written straight away only if conversions are running; otherwise
+//it goes out with the next conversion start.
+void AD7794::setActiveCh(uint8_t ch)
+{
+  if(ch < AD7794_CHANNEL_COUNT){
+    currentCh = ch;
+    bool modeChanged = loadChannelMode(ch);
+    buildConfReg();
+    writeConfReg();
+    if(modeChanged && contConvStarted){
+      writeModeReg();
+    }
+  }
+}
+
+// Writing the mode register starts the conversion. The chip keeps converting
+// with CS high, so the bus is released right away and RDY is checked later
+// through the status register (see poll()).
+void AD7794::startConv()
+{
+  bus->beginTransaction(spiSettings);
+  digitalWrite(CS,LOW);
+  transferModeReg(modeReg);
+  digitalWrite(CS,HIGH);
+  bus->endTransaction();
+}
+
+// Selects ch and starts a conversion on it. A conf reg write that is needed
+// goes out in the same bulk transfer as the mode reg write.
+void AD7794::startConv(uint8_t ch)
+{
+  currentCh = ch;
+  loadChannelMode(ch);
+  buildConfReg();
+
+  bus->beginTransaction(spiSettings);
+  digitalWrite(CS,LOW);
+  if(shadowValid && chipConfReg == confReg){
+    skippedWrites++;
+    transferModeReg(modeReg);
+  }
+  else{
+    AD7794Bus::writeConfMode(*bus, confReg, modeReg);
+    chipConfReg = confReg;
+    chipModeReg = modeReg;
+    AD7794_STAT(stats.confWrites++; stats.modeWrites++; stats.configBytes += 6);
+  }
+  digitalWrite(CS,HIGH);
+  bus->endTransaction();
+}
+
+/* enterLowPower - Puts the chip in idle or power-down mode. Stops a scan
+   without restarting anything. modeReg keeps the conversion mode, so the
+   next conversion start writes it and wakes the chip.
+*/
+void AD7794::enterLowPower(uint8_t md)
+{
+  if(irqActive || streamActive){
+    return;
+  }
+  if(configBatch){
+    commit();
+  }
+  if(scanActive){
+    scanActive = false;
+    if(scanRestoreSingle){
+      isSnglConvMode = true;
+      modeReg = (modeReg & 0x1FFF) | ((uint16_t)AD7794_OpMode_SingleConv << 13);
+    }
+  }
+  contConvStarted = false;
+  acqState = AD7794_Acq_Idle;
+  lowPowerMode = md;
+
+  uint16_t value = (modeReg & 0x1FFF) | ((uint16_t)md << 13);
+  if(shadowValid && chipModeReg == value){
+    skippedWrites++;
+    return;
+  }
+  bus->beginTransaction(spiSettings);
   digitalWrite(CS,LOW);
-  SPI.transfer(AD7794_WRITE_CONF_REG);  
+  transferModeReg(value);
+  digitalWrite(CS,HIGH);
+  bus->endTransaction();
+}
+
+//Typical supply current while converting on ch
+uint16_t AD7794::channelCurrentUa(uint8_t ch)
+{
+  const channelSettings &c = Channel[ch];
+  if(c.gainBits >= 2){
+    return AD7794_IDD_INAMP_UA;
+  }
+  return c.isBuffered ? AD7794_IDD_BUF_UA : AD7794_IDD_UNBUF_UA;
+}
+
+/* trackRange - Auto-range step for a result of ch, converted with the gain
+   in gainBits (from the conf reg the chip had). The first result at a new
+   gain switches the channel's scaling and filter over to it. Steps down at
+   once near full scale or over range, and up only after
+   AD7794_AUTORANGE_HOLD results in a row below AD7794_AUTORANGE_UP.
+*/
+void AD7794::trackRange(uint8_t ch, uint8_t gainBits, uint32_t raw, uint8_t status)
+{
+  channelSettings &c = Channel[ch];
+  if(!c.autoRange){
+    return;
+  }
+
+  if(gainBits != c.gainBits){
+    c.gainBits = gainBits;
+    resetFilter(ch);
+  }
+  if(c.nextGainBits != gainBits){
+    return; //A change is already on its way
+  }
+
+  uint32_t level = raw;
+  if(c.isBipolar){
+    level = raw >= AD7794_ADC_MAX_BP ? raw - AD7794_ADC_MAX_BP : AD7794_ADC_MAX_BP - raw;
+    level <<= 1;
+  }
+  level >>= 16; //Fraction of full scale, x/256
+
+  if((status & AD7794_STATUS_ERR) || level >= AD7794_AUTORANGE_DOWN){
+    c.rangeCount = 0;
+    if(gainBits > c.minGainBits){
+      c.nextGainBits = gainBits - 1;
+    }
+  }
+  else if(level < AD7794_AUTORANGE_UP && gainBits < c.maxGainBits){
+    if(++c.rangeCount >= AD7794_AUTORANGE_HOLD){
+      c.rangeCount = 0;
+      c.nextGainBits = gainBits + 1;
+    }
+  }
+  else{
+    c.rangeCount = 0;
+  }
+
+  if(c.nextGainBits != gainBits){
+    AD7794_STAT(stats.rangeSteps++);
+  }
+}
+
+//True when ch is selected but the chip doesn't have its next gain yet
+bool AD7794::rangePending(uint8_t ch)
+{
+  return ch == currentCh && ((chipConfReg >> 8) & 0x07) != Channel[ch].nextGainBits;
+}
+
+/* checkResultChannel - Called with CS asserted once status shows RDY low.
+   Returns true when the result in the data reg came from ch. Otherwise it
+   is left unread: the conf write that selected ch never reached the chip,
+   or the result predates it. ch is selected again in the same transaction
+   (conf and mode write, which restarts the conversion) so the caller only
+   has to wait out the settling time again.
+*/
+bool AD7794::checkResultChannel(uint8_t status, uint8_t ch)
+{
+  if((status & AD7794_STATUS_CH) == (ch & AD7794_STATUS_CH)){
+    return true;
+  }
+
+  rejectedCount++;
+  setError(AD7794_Err_WrongChannel);
+
+  currentCh = ch;
+  loadChannelMode(ch);
+  buildConfReg();
+  AD7794Bus::writeConfMode(*bus, confReg, modeReg);
+  chipConfReg = confReg;
+  chipModeReg = modeReg;
+  AD7794_STAT(stats.confWrites++; stats.modeWrites++; stats.configBytes += 6);
+  return false;
+}
+
+/* readDataAndSelect - Reads the result and selects the next scan channel
+   in the same bulk transfer: data read, conf write and, if the rate or
+   chop setting changes, mode write. CS must already be asserted. */
+uint32_t AD7794::readDataAndSelect(uint8_t ch)
+{
+  uint8_t buf[10] = {AD7794_READ_DATA_REG, 0xFF, 0xFF, 0xFF};
+  uint8_t len = 7;
+
+  currentCh = ch;
+  buildConfReg();
+  buf[4] = AD7794_WRITE_CONF_REG;
+  buf[5] = confReg >> 8;
+  buf[6] = confReg & 0xFF;
+  chipConfReg = confReg;
+  AD7794_STAT(stats.dataBytes += 4; stats.confWrites++; stats.configBytes += 3);
+
+  if(loadChannelMode(ch)){
+    buf[7] = AD7794_WRITE_MODE_REG;
+    buf[8] = modeReg >> 8;
+    buf[9] = modeReg & 0xFF;
+    len = 10;
+    chipModeReg = modeReg;
+    AD7794_STAT(stats.modeWrites++; stats.configBytes += 3);
+  }
+
+  bus->transfer(buf, len);
+  return ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+}
+
+
+//////// Private helper functions/////////////////
+
+//Reference voltage a channel's codes are relative to. Channels 6 and 7
+//(temperature and AVDD monitor) always use the internal reference.
+float AD7794::refVolts(uint8_t ch)
+{
+  return ch < AD7794_CHANNEL_COUNT - 2 ? vRef : AD7794_INTERNAL_REF_V;
+}
+
+//Integer factors used by toFixed(), from the channel's current settings.
+//The gain is a power of 2, so vRef / gain is a rounded shift.
+AD7794_Scale AD7794::scaleOf(uint8_t ch)
+{
+  const channelSettings &c = Channel[ch];
+  int32_t ref = ch < AD7794_CHANNEL_COUNT - 2 ? vRefFixed :
+                (int32_t)(AD7794_INTERNAL_REF_V * AD7794_FIXED_PER_VOLT + 0.5);
+  AD7794_Scale s;
+
+  s.mult = (ref + ((1L << c.gainBits) >> 1)) >> c.gainBits;
+  s.offset = c.offset;
+  s.zero = c.isBipolar ? AD7794_ADC_MAX_BP : 0;
+  s.shift = c.isBipolar ? 23 : 24;
+  return s;
+}
+
+//Runs a raw result through the channel's filter, if it has one. Returns
+//false when the filter has no output for this sample yet.
+bool AD7794_ISR_ATTR AD7794::filterSample(uint8_t ch, uint32_t &raw)
+{
+  AD7794_Filter *f = Channel[ch].filter;
+  return f == nullptr || f->process(raw, raw);
+}
+
+//Only the selected channel's settings live in the chip's conf reg, any
+//other channel picks up its new settings the next time it is selected
+void AD7794::updateChannel(uint8_t ch)
+{
+  if(ch == currentCh){
+    buildConfReg();
+    writeConfReg();
+  }
+}
+
+//This has been changed and is untested
+void AD7794::buildConfReg()
+{  
+  confReg = AD7794_DEFAULT_CONF_REG; //wipe it back to default
+
+  confReg = (Channel[currentCh].nextGainBits << 8) | currentCh;  
   
-  SPI.transfer16(confReg);
+  if(Channel[currentCh].vBiasEnabled && (currentCh < 3)){
+    uint8_t biasBits = currentCh + 1; 
+    confReg |= (biasBits << 14);
+    confReg |= (1 << 11); //Lets also set the boost bit
+  }
+  
+  confReg |= (!Channel[currentCh].isBipolar << 12);
+  confReg |= (Channel[currentCh].isBuffered << 4);
 
+  //Set reference select bits
+  confReg |= (Channel[currentCh].refMode << 6);   
+
+}
+
+// writeConfReg() and writeModeReg() skip the write when the chip already
+// holds the same value, and defer it while a beginConfig() batch is open
+void AD7794::writeConfReg()
+{
+  if(configBatch){
+    return;
+  }
+  if(shadowValid && chipConfReg == confReg){
+    skippedWrites++;
+    return;
+  }
+
+  bus->beginTransaction(spiSettings);
+  digitalWrite(CS,LOW);
+  transferConfReg();
   digitalWrite(CS,HIGH); 
-  SPI.endTransaction();
+  bus->endTransaction();
+}
+
+//Conf reg write without the transaction, CS must already be asserted
+void AD7794::transferConfReg()
+{
+  AD7794Bus::writeReg16(*bus, AD7794_WRITE_CONF_REG, confReg);
+  chipConfReg = confReg;
+  AD7794_STAT(stats.confWrites++; stats.configBytes += 3);
+}
+
+//Mode reg write without the transaction, CS must already be asserted. Any
+//mode other than idle and power-down wakes the chip.
+void AD7794::transferModeReg(uint16_t value)
+{
+  uint8_t md = value >> 13;
+  if(md != AD7794_OpMode_Idle && md != AD7794_OpMode_PowerDown){
+    lowPowerMode = 0;
+  }
+  AD7794Bus::writeReg16(*bus, AD7794_WRITE_MODE_REG, value);
+  chipModeReg = value;
+  AD7794_STAT(stats.modeWrites++; stats.configBytes += 3);
 }
 
+//While the chip is in idle or power-down, a rate or chop change keeps it
+//there: the mode select bits stay at lowPowerMode.
 void AD7794::writeModeReg()
-{  
-  SPI.beginTransaction(spiSettings);
+{
+  if(configBatch){
+    return;
+  }
+  uint16_t value = modeReg;
+  if(lowPowerMode != 0){
+    value = (modeReg & 0x1FFF) | ((uint16_t)lowPowerMode << 13);
+  }
+  if(shadowValid && chipModeReg == value){
+    skippedWrites++;
+    return;
+  }
+
+  bus->beginTransaction(spiSettings);
   digitalWrite(CS,LOW);  
-  SPI.transfer(AD7794_WRITE_MODE_REG);  
-  
-  SPI.transfer16(modeReg);
+  transferModeReg(value);
 
   digitalWrite(CS,HIGH);
-  SPI.endTransaction();
+  bus->endTransaction();
 }
 
 byte AD7794::getGainBits(uint8_t gain)
@@ -544,3 +2318,65 @@ byte AD7794::getGainBits(uint8_t gain)
   }
   return gainBits;
 }
+
+
+//////// Sample queue /////////////////
+
+AD7794_SampleQueue::AD7794_SampleQueue(AD7794_Sample *storage, uint8_t size)
+{
+  buf = storage;
+  mask = size - 1;
+  head = 0;
+  tail = 0;
+  droppedCount = 0;
+}
+
+bool AD7794_ISR_ATTR AD7794_SampleQueue::push(const AD7794_Sample &sample)
+{
+  uint8_t h = head;
+  if((uint8_t)(h - tail) > mask){
+    droppedCount++; //Full
+    return false;
+  }
+  buf[h & mask] = sample;
+  AD7794_BARRIER();
+  head = h + 1;
+  return true;
+}
+
+bool AD7794_SampleQueue::pop(AD7794_Sample &sample)
+{
+  uint8_t t = tail;
+  if(t == head){
+    return false;
+  }
+  sample = buf[t & mask];
+  AD7794_BARRIER();
+  tail = t + 1;
+  return true;
+}
+
+/* read - Drains up to maxSamples in one go, returns how many were copied */
+uint8_t AD7794_SampleQueue::read(AD7794_Sample *out, uint8_t maxSamples)
+{
+  uint8_t n = 0;
+  while(n < maxSamples && pop(out[n])){
+    n++;
+  }
+  return n;
+}
+
+uint32_t AD7794_SampleQueue::dropped() const
+{
+  noInterrupts();
+  uint32_t n = droppedCount;
+  interrupts();
+  return n;
+}
+
+//Only call while the producer is stopped
+void AD7794_SampleQueue::clear()
+{
+  tail = head;
+  droppedCount = 0;
+}
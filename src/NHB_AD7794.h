@@ -32,22 +32,53 @@
 
 #include <Arduino.h>
 #include <SPI.h>
+#include "NHB_AD7794Filter.h"
+#include "NHB_AD7794Transport.h"
 
 #define AD7794_CHANNEL_COUNT           8    //6 + temp and AVDD Monitor
 
+//Uncomment (or add -DAD7794_ENABLE_STATS to the build flags) to collect
+//run-time statistics, see getStats(). When it is off the counters and the
+//code that updates them are compiled out completely.
+//#define AD7794_ENABLE_STATS
+
 //Communications register settings
 #define AD7794_WRITE_MODE_REG       0x08    //selects mode reg for writing
 #define AD7794_WRITE_CONF_REG       0x10    //selects conf reg for writing
 #define AD7794_READ_DATA_REG        0x58    //selects data reg for reading
 #define AD7794_READ_STATUS_REG      0x40    //selects status register for reading //Added 11-14-2021
+#define AD7794_READ_DATA_CONT       0x5C    //selects data reg for continuous reading (CREAD)
+#define AD7794_READ_OFFSET_REG      0x70    //selects offset reg (current channel) for reading
+#define AD7794_WRITE_OFFSET_REG     0x30    //selects offset reg (current channel) for writing
+#define AD7794_READ_FS_REG          0x78    //selects full-scale reg (current channel) for reading
+#define AD7794_WRITE_FS_REG         0x38    //selects full-scale reg (current channel) for writing
+
+//Status register bits
+#define AD7794_STATUS_RDY           0x80    //Low when a result is waiting in the data reg
+#define AD7794_STATUS_ERR           0x40    //Result over or under range, clamped to all 1s or 0s
+#define AD7794_STATUS_CH            0x07    //Channel the result in the data reg came from
 
 #define AD7794_DEFAULT_MODE_REG   0x2001    //Single conversion mode, Fadc = 470Hz
 #define AD7794_DEFAULT_CONF_REG   0x0010    //CH 0 - Bipolar, Gain = 1, Input buffer enabled
 #define AD7794_CHOP_DISABLE       0x0210    //Chop disable bits in mode register
+#define AD7794_CHANNEL_MODE_BITS  0x021F    //Mode reg bits set per channel (chop and FS3..FS0)
+#define AD7794_POR_MODE_REG       0x000A    //Mode reg after power-on or reset
+#define AD7794_POR_CONF_REG       0x0710    //Conf reg after power-on or reset
   
 #define AD7794_ADC_MAX_UP     16777216U
 #define AD7794_ADC_MAX_BP     8388608
 
+#define AD7794_MAX_IRQ_INSTANCES  4   //AD7794 objects that can stream from the DRDY interrupt at once
+
+//ISRs have to live in IRAM on the Espressif cores
+#if defined(ESP8266) || defined(ESP32)
+  #define AD7794_ISR_ATTR IRAM_ATTR
+#else
+  #define AD7794_ISR_ATTR
+#endif
+
+#define AD7794_FIXED_FRAC_BITS  8   //Fraction bits of the fixed point microvolt results
+
 #define AD7794_INTERNAL_REF_V  1.17
 #define AD7794_REF_EXT_1          0
 #define AD7794_REF_EXT_2          1
@@ -56,26 +87,304 @@
 enum AD7794_OperatingModes {
     AD7794_OpMode_Continuous = 0,           // Continuous conversion mode (default). Only 1 channel 
     AD7794_OpMode_SingleConv,               // Single conversion mode.
-    // *** THESE OPTIONS NOT IMPLEMENTED YET ***
-    // AD7794_OpMode_Idle,                     // Idle mode.
-    // AD7794_OpMode_PowerDown,                // Power-down mode.
-    // AD7794_OpMode_InternalZeroCalibration,  // Internal zero-scale (offset) calibration. 
-    // AD7794_OpMode_InternalFsCalibration,    // Internal full-scale. 
-    // AD7794_OpMode_SystemZeroCalibration,    // System zero-scale (offset) calibration. 
-    // AD7794_OpMode_SystemFsCalibration       // System full-scale.
+    AD7794_OpMode_Idle,                     // Idle mode, modulator and filter held, clock running
+    AD7794_OpMode_PowerDown,                // Power-down mode. Registers are kept
+
+    // Calibrations, run with calibrate() rather than setMode()
+    AD7794_OpMode_InternalZeroCalibration = 4, // Internal zero-scale (offset) calibration. 
+    AD7794_OpMode_InternalFsCalibration,       // Internal full-scale. Not available at gain 128
+    AD7794_OpMode_SystemZeroCalibration,       // System zero-scale (offset) calibration. 
+    AD7794_OpMode_SystemFsCalibration          // System full-scale.
+};
+
+#define AD7794_CAL_CHANNEL_COUNT    6      //Only AIN1..AIN6 have offset/full-scale registers
+#define AD7794_CAL_MAGIC       0x7794      //Marks a stored calibration table
+#define AD7794_CAL_VERSION          1
+#define AD7794_CAL_MAX_RECORDS     24      //Channel/gain pairs kept in storage
+#define AD7794_CAL_HEADER_SIZE      4
+#define AD7794_CAL_RECORD_SIZE      9
+
+/* Storage backend for calibration coefficients (EEPROM, flash, a file...).
+   The table takes AD7794_CAL_HEADER_SIZE + AD7794_CAL_MAX_RECORDS *
+   AD7794_CAL_RECORD_SIZE bytes (220) from address 0 of the backend, so give
+   it an offset in your implementation if the space is shared.
+*/
+class AD7794_CalStorage
+{
+  public:
+    virtual ~AD7794_CalStorage() {}
+
+    virtual bool read(uint16_t addr, uint8_t *buf, uint16_t len) = 0;
+    virtual bool write(uint16_t addr, const uint8_t *buf, uint16_t len) = 0;
+};
+
+#define AD7794_READ_ERROR   0xFFFFFFFF   //getReadingRaw() result on timeout, not a valid 24 bit code
+#define AD7794_FIXED_ERROR  INT32_MIN    //readFixed() result on timeout
+
+enum AD7794_Error {
+    AD7794_Err_None = 0,
+    AD7794_Err_Timeout,                     // RDY did not go low in time
+    AD7794_Err_WrongChannel                 // Result came from another channel, dropped
 };
 
+//Result flags, see AD7794_Sample::flags and getResultFlags()
+#define AD7794_FLAG_RANGE     0x01   //ERR bit was set, the input is over or under range
+
+//Auto-ranging thresholds, in 1/256 of full scale, see setAutoRange().
+//Doubling the gain below UP lands under 80%, clear of DOWN.
+#define AD7794_AUTORANGE_UP     102   //Step the gain up below 40% of full scale
+#define AD7794_AUTORANGE_DOWN   230   //Step it down above 90%, or at once when over range
+#define AD7794_AUTORANGE_HOLD     4   //Results in a row below UP before stepping up (max 15)
+
+#define AD7794_BURST_MAX         32   //Largest n for the median and trimmed mean of readBurst()
+
+#define AD7794_REJECT_RETRIES     2   //Wrong channel results in a row that restart the timeout
+
+//Supply current (uA) used for the charge estimate of scanEvery(). Typical
+//data sheet figures at AVDD = 3 V, excitation currents and bias not included
+#define AD7794_IDD_UNBUF_UA     140   //Converting, gain 1 or 2, unbuffered
+#define AD7794_IDD_BUF_UA       185   //Converting, gain 1 or 2, buffered
+#define AD7794_IDD_INAMP_UA     400   //Converting, gain 4 to 128 (in-amp on)
+#define AD7794_IDD_PD_UA          1   //Power-down
+
+#ifdef AD7794_ENABLE_STATS
+#define AD7794_STAT(x)            do{ x; }while(0)
+#else
+#define AD7794_STAT(x)            do{ }while(0)
+#endif
+
+#define AD7794_STATS_BUCKETS    10   //Wait histogram: <1 ms, 1-2, 2-4 ... 128-256, >=256 ms
+
+// Run-time statistics, only with AD7794_ENABLE_STATS defined
+struct AD7794_Stats
+{
+  uint32_t samples;         //Results delivered (reads, polls, scans, streaming)
+  uint32_t statusPolls;     //Status register reads
+  uint32_t dataBytes;       //SPI bytes spent on status and data reads
+  uint32_t configBytes;     //SPI bytes spent on register writes, resets and calibration access
+  uint32_t confWrites;
+  uint32_t modeWrites;
+  uint32_t timeouts;
+  uint32_t rangeSteps;      //Auto-range gain changes
+  uint32_t maxWaitUs;       //Longest wait for a result
+  uint16_t waitHist[AD7794_CHANNEL_COUNT][AD7794_STATS_BUCKETS];  //Start to ready, per channel
+};
+
+// States of the non-blocking reading engine (startReading()/poll())
+enum AD7794_AcqState {
+    AD7794_Acq_Idle = 0,                    // No reading in progress
+    AD7794_Acq_Converting,                  // Conversion started, bus released, waiting on RDY
+    AD7794_Acq_Ready,                       // Result has been read and is waiting to be collected
+    AD7794_Acq_Timeout                      // RDY did not go low within the timeout
+};
+
+//Update rate code (FS3..FS0) for a rate in Hz, mapped to the next
+//available setting the same way as setUpdateRate()
+constexpr uint8_t AD7794_rateCode(double rate)
+{
+  return rate <= 4.17 ? 0x0F : rate <= 6.25 ? 0x0E : rate <= 8.33 ? 0x0D :
+         rate <= 10   ? 0x0C : rate <= 12.5 ? 0x0B : rate <= 16.7 ? 0x0A :
+         rate <= 19.6 ? 0x08 : rate <= 33.2 ? 0x07 : rate <= 39   ? 0x06 :
+         rate <= 50   ? 0x05 : rate <= 62   ? 0x04 : rate <= 123  ? 0x03 :
+         rate <= 242  ? 0x02 : 0x01;
+}
+
+//Conversion period (1/fADC) and settling time with chop enabled (datasheet
+//Table 19) in us for each FS3..FS0 code. 0 is reserved. With chop disabled
+//the filter settles in one conversion period. AD7794T reads these at compile
+//time, AD7794 from PROGMEM copies in NHB_AD7794.cpp.
+template <typename T = void>
+struct AD7794_Timing
+{
+  static constexpr uint32_t periodUs[16] = {
+    2128, 2128, 4132, 8130, 16129, 20000, 25641, 30120,
+    51020, 59880, 59880, 80000, 100000, 120048, 160000, 239808
+  };
+  static constexpr uint32_t settleUs[16] = {
+    4000, 4000, 8000, 16000, 32000, 40000, 48000, 60000,
+    101000, 120000, 120000, 160000, 200000, 240000, 320000, 480000
+  };
+};
+
+template <typename T> constexpr uint32_t AD7794_Timing<T>::periodUs[16];
+template <typename T> constexpr uint32_t AD7794_Timing<T>::settleUs[16];
+
+/* Settings of one channel, packed into 4 bytes of bit fields plus the offset
+   and filter pointer. Gains are stored as the 3 bit conf reg code (gain =
+   1 << code). The reference voltage is the chip's (internal for channels 6
+   and 7) and the toFixed() factors are derived from these fields when they
+   are needed, so neither is stored per channel.
+   The offset is a voltage (what zero() read), kept in the fixed point
+   microvolts toFixed() subtracts rather than as a raw code. A code's weight
+   depends on gain and polarity, so a raw offset would have to be rescaled
+   on every setGain(), setBipolar() and auto-range step; in microvolts it
+   never changes and the fixed point path uses it as it is.
+*/
 struct channelSettings
 {
-  //Set some defaults
-  uint8_t gain       = 1;
-  bool isBuffered = true;
-  bool isBipolar = true;
-  bool isEnabled  = false;
-  bool vBiasEnabled = false;
-  uint8_t refMode = 0;
-  float offset = 0.0;
-  float vRef = AD7794_INTERNAL_REF_V;
+  channelSettings()
+    : isBuffered(1), isBipolar(1), isEnabled(0), vBiasEnabled(0),
+      chopEnabled(1), autoRange(0), refMode(0),
+      gainBits(0), nextGainBits(0), minGainBits(0), maxGainBits(7),
+      rateCode(AD7794_DEFAULT_MODE_REG & 0x0F), rangeCount(0),
+      offset(0), filter(nullptr) {}
+
+  uint8_t isBuffered   : 1;
+  uint8_t isBipolar    : 1;
+  uint8_t isEnabled    : 1;
+  uint8_t vBiasEnabled : 1;
+  uint8_t chopEnabled  : 1;
+  uint8_t autoRange    : 1;
+  uint8_t refMode      : 2;
+  uint8_t gainBits     : 3;   //Gain of the latest result
+  uint8_t nextGainBits : 3;   //Gain the conf reg is built with
+  uint8_t minGainBits  : 3;   //Auto-range limits
+  uint8_t maxGainBits  : 3;
+  uint8_t rateCode     : 4;   //FS3..FS0, loaded when the channel is selected
+  uint8_t rangeCount   : 4;   //Results in a row below AD7794_AUTORANGE_UP
+  int32_t offset;             //Fixed point microvolts, see toFixed()
+  AD7794_Filter *filter;      //Optional filter on the raw results
+};
+
+
+// How readBurst() combines its results
+enum AD7794_BurstMode {
+    AD7794_Burst_Mean = 0,                  // Plain mean, any number of results
+    AD7794_Burst_TrimmedMean,               // Mean of the middle half (drops the top and bottom n/4)
+    AD7794_Burst_Median                     // Middle result
+};
+
+// Result of readBurst(), in ADC codes
+struct AD7794_BurstResult
+{
+  uint32_t raw;         //Mean, trimmed mean or median, convert it like any other code
+  float stdDev;         //Standard deviation of the results
+  uint32_t peakToPeak;  //Largest minus smallest result
+  uint16_t count;       //Results used
+  uint8_t flags;        //AD7794_FLAG_xxx of any of the results
+};
+
+// One conversion result, as harvested by the DRDY interrupt
+struct AD7794_Sample
+{
+  uint32_t raw;         //24 bit conversion result
+  uint32_t timestamp;   //micros() when the result was read
+  uint8_t channel;
+  uint8_t flags;        //AD7794_FLAG_xxx, always 0 from the DRDY interrupt (no status read)
+  uint8_t gain;         //PGA gain the result was converted with
+};
+
+/* Single producer / single consumer sample queue. The DRDY interrupt pushes,
+   loop() drains. Storage is provided by AD7794_SampleRing<N> below so the
+   size is fixed at compile time and nothing is allocated unless it is used.
+   When the queue is full new samples are dropped and counted.
+*/
+class AD7794_SampleQueue
+{
+  public:
+    bool push(const AD7794_Sample &sample);  //Producer side only
+    bool pop(AD7794_Sample &sample);         //Consumer side only
+    uint8_t read(AD7794_Sample *buf, uint8_t maxSamples);
+    uint8_t available() const { return (uint8_t)(head - tail); }
+    uint8_t capacity() const { return mask + 1; }
+    uint32_t dropped() const;
+    void clear();
+
+  protected:
+    AD7794_SampleQueue(AD7794_Sample *storage, uint8_t size);
+
+  private:
+    AD7794_Sample *buf;
+    uint8_t mask;
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint32_t droppedCount;
+};
+
+// N must be a power of 2, between 2 and 128
+template <uint8_t N>
+class AD7794_SampleRing : public AD7794_SampleQueue
+{
+  static_assert(N >= 2 && N <= 128 && (N & (N - 1)) == 0, "AD7794_SampleRing size must be a power of 2 (2..128)");
+
+  public:
+    AD7794_SampleRing() : AD7794_SampleQueue(storage, N) {}
+
+  private:
+    AD7794_Sample storage[N];
+};
+
+
+/* Low-level register access, shared by AD7794 and the compile-time AD7794T.
+   Everything here runs inside a transaction with CS already asserted. Each
+   access is one bulk transfer on Bus, which is an AD7794_Transport or a
+   SPIClass (anything with transfer(buf, len)).
+*/
+struct AD7794Bus
+{
+  template <typename Bus>
+  static inline void writeReg16(Bus &bus, uint8_t cmd, uint16_t value)
+  {
+    uint8_t buf[3] = {cmd, (uint8_t)(value >> 8), (uint8_t)value};
+    bus.transfer(buf, 3);
+  }
+
+  //Conf then mode register, e.g. select a channel and start a conversion
+  template <typename Bus>
+  static inline void writeConfMode(Bus &bus, uint16_t conf, uint16_t mode)
+  {
+    uint8_t buf[6] = {AD7794_WRITE_CONF_REG, (uint8_t)(conf >> 8), (uint8_t)conf,
+                      AD7794_WRITE_MODE_REG, (uint8_t)(mode >> 8), (uint8_t)mode};
+    bus.transfer(buf, 6);
+  }
+
+  template <typename Bus>
+  static inline void writeReg24(Bus &bus, uint8_t cmd, uint32_t value)
+  {
+    uint8_t buf[4] = {cmd, (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value};
+    bus.transfer(buf, 4);
+  }
+
+  template <typename Bus>
+  static inline uint32_t readReg24(Bus &bus, uint8_t cmd)
+  {
+    uint8_t buf[4] = {cmd, 0xFF, 0xFF, 0xFF};
+    bus.transfer(buf, 4);
+    return ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+  }
+
+  template <typename Bus>
+  static inline uint8_t readStatus(Bus &bus)
+  {
+    uint8_t buf[2] = {AD7794_READ_STATUS_REG, 0xFF};
+    bus.transfer(buf, 2);
+    return buf[1];
+  }
+
+  template <typename Bus>
+  static inline uint32_t readData(Bus &bus)
+  {
+    return readReg24(bus, AD7794_READ_DATA_REG);
+  }
+
+  //32 ones on DIN reset the serial interface and all registers
+  template <typename Bus>
+  static inline void reset(Bus &bus)
+  {
+    uint8_t buf[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+    bus.transfer(buf, 4);
+  }
+};
+
+
+// Precomputed integer scaling for one channel, see toFixed()
+// microvolts << AD7794_FIXED_FRAC_BITS = ((code - zero) * mult >> shift) - offset
+struct AD7794_Scale
+{
+  int32_t mult;     //vRef / gain, in fixed point microvolts
+  int32_t offset;   //channel offset, in fixed point microvolts
+  int32_t zero;     //code for 0 V (0x800000 bipolar, 0 unipolar)
+  uint8_t shift;    //23 bipolar, 24 unipolar
 };
 
 
@@ -84,26 +393,92 @@ class AD7794
   
   public:
     AD7794(uint8_t csPin, uint32_t spiFrequency, double refVoltage);
+    AD7794(uint8_t csPin, uint32_t spiFrequency, double refVoltage, AD7794_Transport &transport);
     void begin();
     void reset();
 
     void setBipolar(uint8_t ch, bool isBipolar);
     void setInputBuffer(uint8_t ch, bool isBuffered);
     void setGain(uint8_t ch, uint8_t gain);
+    uint8_t getGain(uint8_t ch);
+    void setAutoRange(uint8_t ch, bool enabled, uint8_t minGain = 1, uint8_t maxGain = 128);
     void setEnabled(uint8_t ch, bool enabled);
     void setVBias(uint8_t ch, bool enabled);
     void setRefMode(uint8_t ch, uint8_t mode);
+    void setFilter(uint8_t ch, AD7794_Filter *filter);
+    void resetFilter(uint8_t ch);
 
     //void setUpdateRate(uint8_t bitMask);
-    void setUpdateRate(double rate);
+    void setUpdateRate(double rate);              //All channels
+    void setUpdateRate(uint8_t ch, double rate);  //One channel
+    float getUpdateRate(uint8_t ch);
     //void setConvMode(bool isSingle); //Deprecated
     void setMode(AD7794_OperatingModes mode); //Added 11-15-2021
     void setChopEnabled(bool enabled = true); //Added 11-14-2021
+    void setChopEnabled(uint8_t ch, bool enabled);
     void setActiveCh(uint8_t ch);
 
+    //Batch setter calls into the fewest register writes
+    void beginConfig();
+    void commit();
+    uint32_t getSkippedWrites();
+
     uint32_t getReadingRaw(uint8_t ch);
     //float getReadingVolts(uint8_t ch);
     float TempSensorRawToDegC(uint32_t rawData);
+    float rawToVolts(uint8_t ch, uint32_t adcRaw);
+
+    //Fixed point path, microvolts with AD7794_FIXED_FRAC_BITS fraction bits.
+    //Scale factors come from the channel settings with an add and a shift.
+    int32_t toFixed(uint8_t ch, uint32_t adcRaw);
+    void convert(uint8_t ch, const uint32_t *raw, int32_t *out, uint16_t count);
+    int32_t readFixed(uint8_t ch);
+    AD7794_Scale getScale(uint8_t ch);
+
+    //Non-blocking readings. The bus is released while the chip converts,
+    //poll() checks RDY with one short status transaction.
+    bool startReading(uint8_t ch);
+    AD7794_AcqState poll();
+    bool resultReady();
+    uint32_t getResultRaw();
+    float getResult();
+    uint8_t getResultFlags();
+
+    //Blocking, n back to back conversions on one channel in continuous mode
+    bool readBurst(uint8_t ch, uint16_t n, AD7794_BurstMode mode, AD7794_BurstResult &result);
+
+    //Interrupt driven continuous conversion. drdyPin must be an interrupt
+    //capable pin connected to DOUT/RDY (MISO). Holds CS and the SPI bus
+    //until stopContinuousIRQ(), so don't share the bus while streaming.
+    bool startContinuousIRQ(uint8_t ch, uint8_t drdyPin, AD7794_SampleQueue &queue);
+    void stopContinuousIRQ();
+    bool isStreamingIRQ();
+    uint32_t overrunCount();
+
+    //Continuous read (CREAD) streaming. Each sample is just 24 SCLKs after
+    //RDY, no command byte. Holds CS and the bus until stopStreaming().
+    bool startStreaming(uint8_t ch, uint8_t drdyPin = MISO);
+    uint16_t readStream(uint32_t *buf, uint16_t count);
+    void stopStreaming();
+    void resync();
+    bool isStreaming();
+
+    //Multi-channel continuous scanning of the enabled channels. The next
+    //channel is selected right after each result is read.
+    bool startScan();
+    bool pollScan(AD7794_Sample &sample);
+    uint8_t readScan(uint32_t *buf, uint8_t bufSize);
+    void stopScan();
+    bool isScanning();
+    uint32_t getScanWait();             //us before the next scan result can be ready
+    void setScanDiscards(uint8_t count);
+    float getScanRate();
+
+    //Duty-cycled acquisition: wake, one scan, power down. Call from loop()
+    bool scanEvery(uint32_t intervalMs, uint32_t *buf, uint8_t bufSize);
+    void restoreAfterPowerCycle();
+    uint32_t getWakeLatency();          //us, wake to first valid result of the last scanEvery()
+    float getScanCharge();              //uC drawn while awake in the last scanEvery()
 
     void read(float *buf, uint8_t bufSize); //experimental
     float read(uint8_t ch);
@@ -111,21 +486,77 @@ class AD7794
     void zero();            //All enabled, external channels (not internal temperature or VCC monitor)
     float offset(uint8_t ch);
 
+    AD7794_Error getLastError();        //Clears the error
+    uint32_t getTimeoutCount();
+    uint32_t getStatusReads();          //Status register reads made while waiting on RDY
+    uint32_t getRejectedCount();        //Results dropped because they came from the wrong channel
+    uint16_t getTimeout();              //ms, follows update rate and chop setting
+
+#ifdef AD7794_ENABLE_STATS
+    const AD7794_Stats &getStats();
+    void resetStats();
+#endif
+
+    //On-chip calibration, per channel at its current gain
+    bool calibrate(uint8_t ch, AD7794_OperatingModes calMode);
+    bool calibrate(uint8_t ch);   //Internal zero-scale, then internal full-scale
+    uint32_t getOffsetReg(uint8_t ch);
+    uint32_t getFullScaleReg(uint8_t ch);
+    void setOffsetReg(uint8_t ch, uint32_t value);
+    void setFullScaleReg(uint8_t ch, uint32_t value);
+    bool saveCalibration(AD7794_CalStorage &storage);
+    uint8_t restoreCalibration(AD7794_CalStorage &storage);
+
   private:
     //Private helper functions
     void startConv();
+    void startConv(uint8_t ch);
     uint32_t getConvResult();
+    uint8_t readStatusReg();
+    uint32_t readReg24(uint8_t ch, uint8_t cmd);
+    void writeReg24(uint8_t ch, uint8_t cmd, uint32_t value);
+    AD7794_Scale scaleOf(uint8_t ch);
+    float refVolts(uint8_t ch);
+    bool filterSample(uint8_t ch, uint32_t &raw);
     void writeConfReg();
     void writeModeReg();
     void buildConfReg();
+    void updateChannel(uint8_t ch);
     //void setActiveCh(uint8_t ch);
     uint8_t getGainBits(uint8_t gain);
+    void trackRange(uint8_t ch, uint8_t gainBits, uint32_t raw, uint8_t status);
+    bool rangePending(uint8_t ch);
 
     int waitForConvReady(uint32_t timeout); //Added 11-14-2021
+    uint32_t convPeriodUs();
+    uint32_t settleTimeUs();
+    uint32_t convPeriodUs(uint16_t mode);
+    uint32_t settleTimeUs(uint16_t mode);
+    uint16_t channelModeBits(uint8_t ch);
+    bool loadChannelMode(uint8_t ch);
+    void enterLowPower(uint8_t md);
+    uint16_t channelCurrentUa(uint8_t ch);
+    void updateTimeout();
+    void setError(AD7794_Error err);
+    bool checkResultChannel(uint8_t status, uint8_t ch);
+    void transferConfReg();
+    void transferModeReg(uint16_t value);
+    uint8_t scanPosition(uint8_t ch);
+    bool waitForDoutLow(uint32_t timeout);
+    void endContinuous(bool restoreSingle);
 
+    void handleDrdy();
+    template <uint8_t N> static void drdyIsr();
+    static AD7794 *irqOwners[AD7794_MAX_IRQ_INSTANCES];
+
+    void init(uint8_t csPin, uint32_t spiFrequency, double refVoltage);
+    uint32_t readDataAndSelect(uint8_t ch);
+
+    AD7794_Transport *bus;
     uint8_t CS;
     uint8_t currentCh;    
     float vRef;
+    int32_t vRefFixed;    //vRef in fixed point microvolts, see scaleOf()
     
     channelSettings Channel[AD7794_CHANNEL_COUNT];
     SPISettings spiSettings;
@@ -133,9 +564,71 @@ class AD7794
     uint16_t modeReg; //holds value for 16 bit mode register
     uint16_t confReg; //holds value for 16 bit configuration register
 
+    //Shadow of what the chip actually holds, used to skip redundant writes
+    uint16_t chipModeReg;
+    uint16_t chipConfReg;
+    bool shadowValid;
+    bool configBatch;
+    uint32_t skippedWrites;
+
     bool isSnglConvMode;
+    bool contConvStarted;
+
+    //Non-blocking reading state
+    AD7794_AcqState acqState;
+    uint8_t acqCh;
+    uint32_t acqStartTime;
+    uint32_t acqReadyAt;    //micros() before which RDY can't be low yet
+    uint32_t acqResult;
+    uint8_t resultFlags;    //Flags of the result being built (poll or scan), ORed over decimation
+
+    //Error accounting
+    AD7794_Error lastError;
+    uint32_t timeoutCount;
+    uint32_t statusReads;
+    uint32_t rejectedCount;
+
+    //Interrupt driven streaming state
+    AD7794_SampleQueue *irqQueue;
+    uint8_t drdyPin;
+    uint8_t irqSlot;
+    bool irqActive;
+    bool irqRestoreSingle;
+    uint32_t lastIrqTime;
+    volatile uint32_t irqOverruns;
 
-    const uint16_t convTimeout = 480; // This should be set based on update rate eventually
+    //Scan engine state
+    uint8_t scanList[AD7794_CHANNEL_COUNT];
+    uint8_t scanCount;
+    uint8_t scanIdx;
+    uint8_t scanDiscards;
+    uint8_t scanDiscardsLeft;
+    bool scanActive;
+    bool scanRestoreSingle;
+    uint32_t scanWaitStart;
+    uint32_t scanReadyAt;
+
+    //Continuous read streaming state
+    bool streamActive;
+    bool streamRestoreSingle;
+
+    //Duty cycle state, see scanEvery()
+    bool dutyStarted;
+    uint8_t lowPowerMode;   //MD bits of idle or power-down while the chip is in it, else 0
+    uint32_t dutyLastMs;
+    uint32_t wakeLatencyUs;
+    float scanCharge;
+
+    uint16_t convTimeout;   //ms, set from the settling time by updateTimeout()
+    uint8_t rejectRun;      //Wrong channel results since the last good one
+
+#ifdef AD7794_ENABLE_STATS
+    void recordWait(uint8_t ch, uint32_t startUs);
+
+    AD7794_Stats stats;
+    uint32_t acqStartUs;
+    uint32_t scanStartUs;
+#endif
 
 };
 
@@ -0,0 +1,191 @@
+/*
+  NHB_AD7794Array.cpp - Runs several AD7794s on one SPI bus side by side
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "NHB_AD7794Array.h"
+
+AD7794Array::AD7794Array()
+{
+  chipCount = 0;
+  pending = 0;
+}
+
+/* add - Adds a chip to the array. Returns false if the array is full. */
+bool AD7794Array::add(AD7794 &chip)
+{
+  if(chipCount >= AD7794_ARRAY_MAX_CHIPS){
+    return false;
+  }
+
+  chips[chipCount++] = &chip;
+  return true;
+}
+
+uint8_t AD7794Array::size()
+{
+  return chipCount;
+}
+
+AD7794 &AD7794Array::chip(uint8_t index)
+{
+  return *chips[index < chipCount ? index : 0];
+}
+
+void AD7794Array::begin()
+{
+  for(uint8_t i = 0; i < chipCount; i++){
+    chips[i]->begin();
+  }
+}
+
+void AD7794Array::setUpdateRate(double rate)
+{
+  for(uint8_t i = 0; i < chipCount; i++){
+    chips[i]->setUpdateRate(rate);
+  }
+}
+
+bool AD7794Array::startReading(uint8_t ch)
+{
+  bool ok = true;
+
+  for(uint8_t i = 0; i < chipCount; i++){
+    if(chips[i]->startReading(ch)){
+      pending |= (1 << i);
+    }
+    else{
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+bool AD7794Array::startReading(const uint8_t *channels)
+{
+  bool ok = true;
+
+  for(uint8_t i = 0; i < chipCount; i++){
+    if(chips[i]->startReading(channels[i])){
+      pending |= (1 << i);
+    }
+    else{
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+/* poll - Checks every chip that is still converting, one short status read
+   each, and returns a bit mask of the chips whose result is waiting.
+   A chip that timed out is dropped from the pending set.
+*/
+uint8_t AD7794Array::poll()
+{
+  uint8_t ready = 0;
+
+  for(uint8_t i = 0; i < chipCount; i++){
+    if(!(pending & (1 << i))){
+      continue;
+    }
+
+    AD7794_AcqState state = chips[i]->poll();
+    if(state == AD7794_Acq_Ready){
+      ready |= (1 << i);
+    }
+    else if(state != AD7794_Acq_Converting){
+      pending &= ~(1 << i);
+    }
+  }
+  return ready;
+}
+
+bool AD7794Array::busy()
+{
+  for(uint8_t i = 0; i < chipCount; i++){
+    if((pending & (1 << i)) && chips[i]->poll() == AD7794_Acq_Converting){
+      return true;
+    }
+  }
+  return false;
+}
+
+bool AD7794Array::resultReady(uint8_t index)
+{
+  return index < chipCount && chips[index]->resultReady();
+}
+
+uint32_t AD7794Array::getResultRaw(uint8_t index)
+{
+  pending &= ~(1 << index);
+  return chip(index).getResultRaw();
+}
+
+float AD7794Array::getResult(uint8_t index)
+{
+  pending &= ~(1 << index);
+  return chip(index).getResult();
+}
+
+/* readRaw - Converts channel ch on every chip at the same time and puts
+   the raw results in out[chip]
+*/
+uint8_t AD7794Array::readRaw(uint8_t ch, uint32_t *out)
+{
+  startReading(ch);
+  uint8_t done = waitAll();
+
+  for(uint8_t i = 0; i < chipCount; i++){
+    if(done & (1 << i)){
+      out[i] = getResultRaw(i);
+    }
+  }
+  return done;
+}
+
+uint8_t AD7794Array::read(uint8_t ch, float *out)
+{
+  startReading(ch);
+  uint8_t done = waitAll();
+
+  for(uint8_t i = 0; i < chipCount; i++){
+    if(done & (1 << i)){
+      out[i] = getResult(i);
+    }
+  }
+  return done;
+}
+
+//Polls until no chip is converting anymore, returns the ready mask
+uint8_t AD7794Array::waitAll()
+{
+  uint8_t ready = 0;
+
+  while(pending & ~ready){
+    ready = poll();
+  }
+  return ready;
+}
@@ -0,0 +1,76 @@
+/*
+  NHB_AD7794Array.h - Runs several AD7794s on one SPI bus side by side
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef NHB_AD7794_ARRAY_h
+#define NHB_AD7794_ARRAY_h
+
+#include "NHB_AD7794.h"
+
+#define AD7794_ARRAY_MAX_CHIPS    4
+
+/* Coordinates up to AD7794_ARRAY_MAX_CHIPS chips sharing one SPI bus (each
+   with its own CS). Conversions are started on every chip and the bus is
+   released while they convert, so the chips work in parallel instead of one
+   after another. Each chip keeps its own channel settings and offsets, set
+   up through its AD7794 object as usual.
+*/
+class AD7794Array
+{
+  public:
+    AD7794Array();
+
+    bool add(AD7794 &chip);
+    uint8_t size();
+    AD7794 &chip(uint8_t index);
+
+    void begin();
+    void setUpdateRate(double rate);
+
+    //Non-blocking
+    bool startReading(uint8_t ch);                //Same channel on every chip
+    bool startReading(const uint8_t *channels);   //One channel per chip
+    uint8_t poll();                               //Bit mask of chips with a result
+    bool busy();                                  //Any chip still converting
+    bool resultReady(uint8_t index);
+    uint32_t getResultRaw(uint8_t index);
+    float getResult(uint8_t index);
+
+    //Blocking, one result per chip. Returns a bit mask of the chips that
+    //delivered, chips that timed out are left out.
+    uint8_t readRaw(uint8_t ch, uint32_t *out);
+    uint8_t read(uint8_t ch, float *out);
+
+  private:
+    uint8_t waitAll();
+
+    AD7794 *chips[AD7794_ARRAY_MAX_CHIPS];
+    uint8_t chipCount;
+    uint8_t pending;    //Bit mask of chips started and not yet collected
+};
+
+#endif
@@ -0,0 +1,122 @@
+/*
+  NHB_AD7794Filter.cpp - Integer filters for raw AD7794 conversion results
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "NHB_AD7794Filter.h"
+
+/* process - Runs a sample through this filter and the rest of the chain.
+   Returns true when the end of the chain produced an output.
+*/
+bool AD7794_Filter::process(uint32_t in, uint32_t &out)
+{
+  AD7794_Filter *f = this;
+  uint32_t v = in;
+
+  while(f != nullptr){
+    if(!f->push(v, v)){
+      return false;
+    }
+    f = f->next;
+  }
+  out = v;
+  return true;
+}
+
+AD7794_Filter &AD7794_Filter::then(AD7794_Filter &nextFilter)
+{
+  next = &nextFilter;
+  return nextFilter;
+}
+
+//Clears the state of every filter in the chain
+void AD7794_Filter::reset()
+{
+  for(AD7794_Filter *f = this; f != nullptr; f = f->next){
+    f->clear();
+  }
+}
+
+uint16_t AD7794_Filter::getRatio()
+{
+  uint16_t r = 1;
+  for(AD7794_Filter *f = this; f != nullptr; f = f->next){
+    r *= f->ratio;
+  }
+  return r;
+}
+
+
+AD7794_EMA::AD7794_EMA(uint8_t shift)
+{
+  this->shift = (shift < 1) ? 1 : (shift > 7 ? 7 : shift);
+  clear();
+}
+
+bool AD7794_EMA::push(uint32_t in, uint32_t &out)
+{
+  if(!primed){
+    acc = in << shift; //Start at the first sample instead of ramping up from 0
+    primed = true;
+  }
+  else{
+    acc = acc - (acc >> shift) + in;
+  }
+
+  out = (acc + (1UL << (shift - 1))) >> shift;
+  return true;
+}
+
+void AD7794_EMA::clear()
+{
+  acc = 0;
+  primed = false;
+}
+
+
+AD7794_Decimator::AD7794_Decimator(uint8_t factor)
+{
+  ratio = (factor < 1) ? 1 : factor;
+  clear();
+}
+
+bool AD7794_Decimator::push(uint32_t in, uint32_t &out)
+{
+  sum += in;
+  if(++count < ratio){
+    return false;
+  }
+
+  out = (sum + ratio / 2) / ratio;
+  clear();
+  return true;
+}
+
+void AD7794_Decimator::clear()
+{
+  sum = 0;
+  count = 0;
+}
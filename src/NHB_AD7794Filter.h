@@ -0,0 +1,189 @@
+/*
+  NHB_AD7794Filter.h - Integer filters for raw AD7794 conversion results
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef NHB_AD7794_FILTER_h
+#define NHB_AD7794_FILTER_h
+
+#include <Arduino.h>
+
+/* Base class of the per channel filters. Filters work on raw 24 bit codes,
+   before scaling, with integer math only and storage that is part of the
+   object (no heap). process() takes one sample and returns true when it put
+   a new output in out. A filter that only outputs every Nth sample (the
+   decimator) makes the driver convert N times for every result it returns.
+
+   Filters can be chained with then(), e.g. a median to knock out spikes
+   followed by a decimator:  median.then(decimator);
+*/
+class AD7794_Filter
+{
+  public:
+    AD7794_Filter() : next(nullptr), ratio(1) {}
+    virtual ~AD7794_Filter() {}
+
+    bool process(uint32_t in, uint32_t &out);
+    AD7794_Filter &then(AD7794_Filter &nextFilter);
+    void reset();
+    uint16_t getRatio();  //Input samples per output, whole chain
+
+    virtual bool push(uint32_t in, uint32_t &out) = 0;
+    virtual void clear() = 0;
+
+  protected:
+    AD7794_Filter *next;
+    uint8_t ratio;
+};
+
+
+/* Moving average over N samples, O(1) per sample with a running sum.
+   Outputs every sample (the average of what it has so far until the window
+   is full). N up to 255.
+*/
+template <uint8_t N>
+class AD7794_MovingAverage : public AD7794_Filter
+{
+  public:
+    AD7794_MovingAverage() { clear(); }
+
+    bool push(uint32_t in, uint32_t &out)
+    {
+      if(count == N){
+        sum -= buf[idx];
+      }
+      else{
+        count++;
+      }
+      buf[idx] = in;
+      sum += in;
+      idx = (idx + 1 < N) ? idx + 1 : 0;
+
+      out = (sum + count / 2) / count;
+      return true;
+    }
+
+    void clear()
+    {
+      sum = 0;
+      idx = 0;
+      count = 0;
+    }
+
+  private:
+    static_assert(N >= 1, "AD7794_MovingAverage window must be at least 1");
+
+    uint32_t buf[N];
+    uint32_t sum;   //24 bit codes, fits for N <= 255
+    uint8_t idx;
+    uint8_t count;
+};
+
+
+/* Median of the last N samples (N odd, up to 15) for spike rejection.
+   Outputs every sample.
+*/
+template <uint8_t N>
+class AD7794_Median : public AD7794_Filter
+{
+  public:
+    AD7794_Median() { clear(); }
+
+    bool push(uint32_t in, uint32_t &out)
+    {
+      buf[idx] = in;
+      idx = (idx + 1 < N) ? idx + 1 : 0;
+      if(count < N){
+        count++;
+      }
+
+      //Insertion sort of a copy, cheap for the small windows this is for
+      uint32_t sorted[N];
+      for(uint8_t i = 0; i < count; i++){
+        uint32_t v = buf[i];
+        uint8_t j = i;
+        while(j > 0 && sorted[j - 1] > v){
+          sorted[j] = sorted[j - 1];
+          j--;
+        }
+        sorted[j] = v;
+      }
+
+      out = sorted[count / 2];
+      return true;
+    }
+
+    void clear()
+    {
+      idx = 0;
+      count = 0;
+    }
+
+  private:
+    static_assert(N % 2 == 1 && N <= 15, "AD7794_Median window must be odd and at most 15");
+
+    uint32_t buf[N];
+    uint8_t idx;
+    uint8_t count;
+};
+
+
+/* Exponential moving average, y += (x - y) / 2^shift, in integer math.
+   The state keeps shift extra fraction bits so small steps are not lost.
+   shift 1..7, time constant about 2^shift samples. Outputs every sample.
+*/
+class AD7794_EMA : public AD7794_Filter
+{
+  public:
+    AD7794_EMA(uint8_t shift = 3);
+
+    bool push(uint32_t in, uint32_t &out);
+    void clear();
+
+  private:
+    uint32_t acc;     //Output << shift
+    uint8_t shift;
+    bool primed;
+};
+
+
+/* N:1 decimator. Averages N samples and outputs once per N (boxcar
+   average and dump). N up to 255.
+*/
+class AD7794_Decimator : public AD7794_Filter
+{
+  public:
+    AD7794_Decimator(uint8_t factor = 4);
+
+    bool push(uint32_t in, uint32_t &out);
+    void clear();
+
+  private:
+    uint32_t sum;
+    uint8_t count;
+};
+
+#endif
@@ -0,0 +1,117 @@
+/*
+  NHB_AD7794Frame.cpp - Compact binary frames for streaming raw samples
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "NHB_AD7794Frame.h"
+#include "NHB_AD7794.h"
+
+static_assert(AD7794_FRAME_FRAC_BITS == AD7794_FIXED_FRAC_BITS, "Scale frames carry the toFixed() factors");
+
+static inline uint8_t *putLE(uint8_t *p, uint32_t value, uint8_t bytes)
+{
+  for(uint8_t i = 0; i < bytes; i++){
+    *p++ = value & 0xFF;
+    value >>= 8;
+  }
+  return p;
+}
+
+AD7794_FrameEncoder::AD7794_FrameEncoder(uint8_t channelMask)
+{
+  mask = channelMask;
+  sequence = 0;
+}
+
+void AD7794_FrameEncoder::setChannelMask(uint8_t channelMask)
+{
+  mask = channelMask;
+}
+
+uint8_t AD7794_FrameEncoder::getChannelMask()
+{
+  return mask;
+}
+
+uint8_t AD7794_FrameEncoder::frameSize()
+{
+  return AD7794_frameSize(mask);
+}
+
+uint16_t AD7794_FrameEncoder::getSequence()
+{
+  return sequence;
+}
+
+uint8_t AD7794_FrameEncoder::encode(uint8_t *dst, uint16_t space, const uint32_t *raw, uint32_t timestamp)
+{
+  return write(dst, space, mask, raw, timestamp);
+}
+
+uint8_t AD7794_FrameEncoder::encode(uint8_t *dst, uint16_t space, const AD7794_Sample &sample)
+{
+  if(sample.channel >= 8){
+    return 0;
+  }
+  return write(dst, space, 1 << sample.channel, &sample.raw, sample.timestamp);
+}
+
+uint8_t AD7794_FrameEncoder::encodeScale(uint8_t *dst, uint16_t space, uint8_t ch, const AD7794_Scale &scale)
+{
+  if(space < AD7794_FRAME_SCALE_SIZE){
+    return 0;
+  }
+
+  uint8_t *p = dst;
+  *p++ = AD7794_FRAME_SYNC_SCALE;
+  *p++ = ch;
+  p = putLE(p, (uint32_t)scale.mult, 4);
+  p = putLE(p, (uint32_t)scale.offset, 4);
+  p = putLE(p, (uint32_t)scale.zero, 4);
+  *p++ = scale.shift;
+  putLE(p, AD7794_frameCrc(dst, p - dst), 2);
+  return AD7794_FRAME_SCALE_SIZE;
+}
+
+uint8_t AD7794_FrameEncoder::write(uint8_t *dst, uint16_t space, uint8_t frameMask, const uint32_t *raw, uint32_t timestamp)
+{
+  uint8_t size = AD7794_frameSize(frameMask);
+
+  if(space < size || frameMask == 0){
+    return 0;
+  }
+
+  uint8_t *p = dst;
+  *p++ = AD7794_FRAME_SYNC_DATA;
+  *p++ = frameMask;
+  p = putLE(p, sequence++, 2);
+  p = putLE(p, timestamp, 4);
+  for(uint8_t m = frameMask; m != 0; m &= m - 1){
+    p = putLE(p, *raw++, 3);
+  }
+  putLE(p, AD7794_frameCrc(dst, p - dst), 2);
+  return size;
+}
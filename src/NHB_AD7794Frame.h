@@ -0,0 +1,119 @@
+/*
+  NHB_AD7794Frame.h - Compact binary frames for streaming raw samples
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef NHB_AD7794_FRAME_h
+#define NHB_AD7794_FRAME_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Frame layout, all multi-byte fields little endian. The CRC is CRC-16/CCITT
+   (polynomial 0x1021, init 0xFFFF) over every byte before it.
+
+   Data frame, 10 + 3 * (channels in mask) bytes:
+     0  sync        AD7794_FRAME_SYNC_DATA
+     1  mask        bit n set = channel n present
+     2  sequence    uint16, +1 per data frame, gaps mean lost frames
+     4  timestamp   uint32, micros() of the newest sample
+     8  codes       24 bit raw codes, lowest channel first
+     .  crc         uint16
+
+   Scale frame, 17 bytes, the AD7794_Scale of one channel so the receiver
+   can convert with the same integer math as AD7794::toFixed():
+     0  sync        AD7794_FRAME_SYNC_SCALE
+     1  channel
+     2  mult        int32
+     6  offset      int32
+     10 zero        int32
+     14 shift       uint8
+     15 crc         uint16
+
+   Nothing here depends on Arduino, so the host decoder includes this file
+   for the constants and the CRC.
+*/
+#define AD7794_FRAME_SYNC_DATA      0xA5
+#define AD7794_FRAME_SYNC_SCALE     0xA6
+#define AD7794_FRAME_HEADER_SIZE    8
+#define AD7794_FRAME_CRC_SIZE       2
+#define AD7794_FRAME_SCALE_SIZE     17
+#define AD7794_FRAME_MAX_SIZE       (AD7794_FRAME_HEADER_SIZE + 3 * 8 + AD7794_FRAME_CRC_SIZE)
+#define AD7794_FRAME_FRAC_BITS      8   //Scale frames give fixed point microvolts with this many fraction bits
+
+struct AD7794_Scale;
+struct AD7794_Sample;
+
+static inline uint16_t AD7794_frameCrc(const uint8_t *buf, uint16_t len)
+{
+  uint16_t crc = 0xFFFF;
+  for(uint16_t i = 0; i < len; i++){
+    crc ^= (uint16_t)buf[i] << 8;
+    for(uint8_t b = 0; b < 8; b++){
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+static inline uint8_t AD7794_frameSize(uint8_t mask)
+{
+  uint8_t n = 0;
+  for(; mask != 0; mask &= mask - 1){
+    n++;
+  }
+  return AD7794_FRAME_HEADER_SIZE + 3 * n + AD7794_FRAME_CRC_SIZE;
+}
+
+/* Packs samples into frames, straight into a buffer owned by the caller
+   (e.g. a block that is handed to Serial.write() once it is full). Each
+   encode returns the number of bytes written, 0 if they didn't fit.
+*/
+class AD7794_FrameEncoder
+{
+  public:
+    AD7794_FrameEncoder(uint8_t channelMask = 0);
+
+    void setChannelMask(uint8_t mask);
+    uint8_t getChannelMask();
+    uint8_t frameSize();          //Data frame size for the channel mask
+    uint16_t getSequence();       //Sequence number of the next data frame
+
+    //One code per channel in the mask, lowest channel first (the order of
+    //readScan() and read(buf,size))
+    uint8_t encode(uint8_t *dst, uint16_t space, const uint32_t *raw, uint32_t timestamp);
+    //A single sample, e.g. from the interrupt queue or pollScan()
+    uint8_t encode(uint8_t *dst, uint16_t space, const AD7794_Sample &sample);
+    uint8_t encodeScale(uint8_t *dst, uint16_t space, uint8_t ch, const AD7794_Scale &scale);
+
+  private:
+    uint8_t write(uint8_t *dst, uint16_t space, uint8_t mask, const uint32_t *raw, uint32_t timestamp);
+
+    uint8_t mask;
+    uint16_t sequence;
+};
+
+#endif
@@ -0,0 +1,272 @@
+/*
+  NHB_AD7794Rtos.cpp - Shared bus locking and a dedicated acquisition task
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "NHB_AD7794Rtos.h"
+
+#ifdef AD7794_RTOS_AVAILABLE
+
+//Bare metal ARM toolchains ship <thread> without the gthreads it needs,
+//so std::this_thread is only used where the library has threads
+#if !defined(ESP32) && (defined(_GLIBCXX_HAS_GTHREADS) || \
+                        (defined(_LIBCPP_VERSION) && !defined(_LIBCPP_HAS_NO_THREADS)))
+  #include <thread>
+  #define AD7794_HAS_STD_THREAD
+#endif
+
+
+//////// Broadcast ring /////////////////
+
+AD7794_Broadcast::AD7794_Broadcast(Slot *storage, uint16_t size)
+  : slots(storage), mask(size - 1), head(0)
+{
+  for(uint16_t i = 0; i < size; i++){
+    slots[i].seq.store(0, std::memory_order_relaxed);
+    slots[i].word.store(0, std::memory_order_relaxed);
+    slots[i].timestamp.store(0, std::memory_order_relaxed);
+  }
+}
+
+void AD7794_Broadcast::publish(const AD7794_Sample &sample)
+{
+  uint32_t pos = head.load(std::memory_order_relaxed);
+  Slot &slot = slots[pos & mask];
+
+  uint8_t gainCode = 0;
+  while(gainCode < 7 && (1 << gainCode) < sample.gain){
+    gainCode++;
+  }
+  uint32_t word = (sample.raw & 0xFFFFFF) | ((uint32_t)(sample.channel & 0x07) << 24) |
+                  ((uint32_t)gainCode << 27) | ((uint32_t)(sample.flags & 0x03) << 30);
+
+  slot.seq.store(2 * pos + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.word.store(word, std::memory_order_relaxed);
+  slot.timestamp.store(sample.timestamp, std::memory_order_relaxed);
+  slot.seq.store(2 * pos + 2, std::memory_order_release);
+  head.store(pos + 1, std::memory_order_release);
+}
+
+AD7794_BroadcastReader::AD7794_BroadcastReader(AD7794_Broadcast &ring)
+  : ring(ring), pos(ring.published()), lostCount(0)
+{
+}
+
+bool AD7794_BroadcastReader::read(AD7794_Sample &sample)
+{
+  for(;;){
+    uint32_t head = ring.published();
+    if(pos == head){
+      return false;
+    }
+    if(head - pos > ring.capacity()){
+      //Overwritten already, skip to the oldest sample still in the ring
+      lostCount += head - pos - ring.capacity();
+      pos = head - ring.capacity();
+    }
+
+    const AD7794_Broadcast::Slot &slot = ring.slots[pos & ring.mask];
+    uint32_t seq = slot.seq.load(std::memory_order_acquire);
+    uint32_t word = slot.word.load(std::memory_order_relaxed);
+    uint32_t timestamp = slot.timestamp.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if(seq != 2 * pos + 2 || slot.seq.load(std::memory_order_relaxed) != seq){
+      //The producer lapped us on this slot while it was being read
+      lostCount++;
+      pos++;
+      continue;
+    }
+
+    sample.raw = word & 0xFFFFFF;
+    sample.channel = (word >> 24) & 0x07;
+    sample.gain = 1 << ((word >> 27) & 0x07);
+    sample.flags = word >> 30;
+    sample.timestamp = timestamp;
+    pos++;
+    return true;
+  }
+}
+
+uint16_t AD7794_BroadcastReader::available() const
+{
+  uint32_t n = ring.published() - pos;
+  return n > ring.capacity() ? ring.capacity() : n;
+}
+
+
+//////// Acquisition task /////////////////
+
+AD7794_Acquisition::AD7794_Acquisition(AD7794 &adc, AD7794_Broadcast &out)
+  : adc(adc), out(out), running(false), stopRequested(false), callState(CallFree),
+    callFn(nullptr), callArg(nullptr)
+{
+}
+
+/* step - Runs a call() that is waiting, then polls the scan once. The scan
+   is (re)started here, so it always runs on the acquisition task.
+*/
+bool AD7794_Acquisition::step()
+{
+  if(callState.load(std::memory_order_acquire) == CallPosted){
+    adc.stopScan();
+    callFn(adc, callArg);
+    callState.store(CallDone, std::memory_order_release);
+  }
+
+  if(!adc.isScanning() && !adc.startScan()){
+    return false; //No channel enabled
+  }
+
+  AD7794_Sample sample;
+  if(adc.pollScan(sample)){
+    out.publish(sample);
+    return true;
+  }
+  return false;
+}
+
+void AD7794_Acquisition::run()
+{
+  running.store(true);
+  while(!stopRequested.load(std::memory_order_acquire)){
+    if(!step()){
+      uint32_t wait = adc.getScanWait();
+      pause(wait < AD7794_ACQ_MAX_PAUSE_US ? wait : AD7794_ACQ_MAX_PAUSE_US);
+    }
+  }
+  adc.stopScan();
+
+  //A call() posted while stopping still runs, here
+  uint8_t posted = CallPosted;
+  if(callState.compare_exchange_strong(posted, CallClaimed, std::memory_order_acquire)){
+    callFn(adc, callArg);
+    callState.store(CallDone, std::memory_order_release);
+  }
+  stopRequested.store(false);
+  running.store(false);
+}
+
+/* call - Runs fn(adc, arg) on the acquisition task and waits until it is
+   done. Callers from several tasks take turns. When the task isn't
+   running, fn runs right here. Returns false if the task ended before it
+   picked fn up, in which case fn didn't run.
+*/
+bool AD7794_Acquisition::call(AD7794_Command fn, void *arg)
+{
+  if(!running.load()){
+    fn(adc, arg);
+    return true;
+  }
+
+  uint8_t expected = CallFree;
+  while(!callState.compare_exchange_weak(expected, CallClaimed, std::memory_order_acquire)){
+    expected = CallFree;
+    waitTurn();
+  }
+  callFn = fn;
+  callArg = arg;
+  callState.store(CallPosted, std::memory_order_release);
+
+  while(callState.load(std::memory_order_acquire) != CallDone){
+    if(!running.load()){
+      //The task is gone. Take the call back unless it was picked up after all
+      uint8_t posted = CallPosted;
+      if(callState.compare_exchange_strong(posted, CallFree, std::memory_order_acquire)){
+        return false;
+      }
+    }
+    waitTurn();
+  }
+  callState.store(CallFree, std::memory_order_release);
+  return true;
+}
+
+/* markRunning - Makes call() post to the task from now on. Call it before
+   creating the thread or task that runs run(), otherwise a call() made in
+   between runs fn at the same time as the first step(). start() does it on
+   ESP32. Returns false if the task is already running.
+*/
+bool AD7794_Acquisition::markRunning()
+{
+  bool idle = false;
+  return running.compare_exchange_strong(idle, true);
+}
+
+void AD7794_Acquisition::stop()
+{
+  stopRequested.store(true, std::memory_order_release);
+}
+
+void AD7794_Acquisition::pause(uint32_t us)
+{
+#if defined(ESP32)
+  const uint32_t tickUs = portTICK_PERIOD_MS * 1000;
+  if(us >= tickUs){
+    vTaskDelay(us / tickUs);
+    return;
+  }
+#endif
+  delayMicroseconds(us > 0 ? us : AD7794_ACQ_POLL_GAP_US);
+#if !defined(ESP32)
+  waitTurn(); //Lets consumers of the same priority run
+#endif
+}
+
+//Waiting in call(), without touching the bus or the chip
+void AD7794_Acquisition::waitTurn()
+{
+#if defined(ESP32)
+  vTaskDelay(1);
+#elif defined(AD7794_HAS_STD_THREAD)
+  std::this_thread::yield();
+#else
+  yield();
+#endif
+}
+
+#if defined(ESP32)
+bool AD7794_Acquisition::start(uint32_t stackBytes, UBaseType_t priority, BaseType_t core)
+{
+  if(!markRunning()){
+    return false;
+  }
+  if(xTaskCreatePinnedToCore(taskEntry, "AD7794", stackBytes, this, priority, nullptr, core) != pdPASS){
+    running.store(false);
+    return false;
+  }
+  return true;
+}
+
+void AD7794_Acquisition::taskEntry(void *arg)
+{
+  static_cast<AD7794_Acquisition *>(arg)->run();
+  vTaskDelete(nullptr);
+}
+#endif
+
+#endif //AD7794_RTOS_AVAILABLE
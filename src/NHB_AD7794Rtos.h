@@ -0,0 +1,220 @@
+/*
+  NHB_AD7794Rtos.h - Shared bus locking and a dedicated acquisition task
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef NHB_AD7794_RTOS_h
+#define NHB_AD7794_RTOS_h
+
+#include "NHB_AD7794.h"
+
+/* Needs <atomic> with lock-free compare and swap (ESP32, Cortex-M3 and up,
+   Linux hosts). On other cores, like AVR and the Cortex-M0+ of the SAMD21,
+   this header declares nothing.
+*/
+#if defined(__has_include) && !defined(__ARM_ARCH_6M__)
+  #if __has_include(<atomic>)
+    #define AD7794_RTOS_AVAILABLE
+  #endif
+#endif
+
+#ifdef AD7794_RTOS_AVAILABLE
+
+#include <atomic>
+
+#if defined(ESP32)
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/semphr.h>
+  #include <freertos/task.h>
+#endif
+
+/* A lock for one SPI bus. Every device on the bus, the AD7794 and anything
+   else, takes it for the length of its transactions.
+*/
+class AD7794_BusLock
+{
+  public:
+    virtual ~AD7794_BusLock() {}
+
+    virtual void lock() = 0;
+    virtual void unlock() = 0;
+};
+
+#if defined(ESP32)
+//FreeRTOS mutex, with priority inheritance
+class AD7794_FreeRtosLock : public AD7794_BusLock
+{
+  public:
+    AD7794_FreeRtosLock() : mutex(xSemaphoreCreateMutex()) {}
+    void lock() { xSemaphoreTake(mutex, portMAX_DELAY); }
+    void unlock() { xSemaphoreGive(mutex); }
+
+  private:
+    SemaphoreHandle_t mutex;
+};
+#endif
+
+/* Transport that holds a bus lock from beginTransaction() to
+   endTransaction(), around another transport. The driver opens exactly one
+   transaction per register access or poll, and never nests them, so a
+   plain (non recursive) mutex is enough.
+*/
+class AD7794_LockedTransport : public AD7794_Transport
+{
+  public:
+    AD7794_LockedTransport(AD7794_Transport &inner, AD7794_BusLock &lock) : inner(inner), busLock(lock) {}
+
+    void begin() { inner.begin(); }
+    void beginTransaction(const SPISettings &settings) { busLock.lock(); inner.beginTransaction(settings); }
+    void endTransaction() { inner.endTransaction(); busLock.unlock(); }
+    uint8_t transfer(uint8_t data) { return inner.transfer(data); }
+    void transfer(uint8_t *buf, uint16_t len) { inner.transfer(buf, len); }
+
+  private:
+    AD7794_Transport &inner;
+    AD7794_BusLock &busLock;
+};
+
+/* Broadcast ring, one producer and any number of readers. Unlike
+   AD7794_SampleQueue every reader sees every sample, and the producer never
+   waits: a reader that falls more than the ring size behind loses the
+   oldest samples and counts them. Each slot is a seqlock, so a reader that
+   races the producer on a slot notices and skips it rather than returning
+   a torn sample. Storage is in AD7794_BroadcastRing<N>.
+*/
+class AD7794_Broadcast
+{
+  public:
+    void publish(const AD7794_Sample &sample);  //Producer side only
+    uint32_t published() const { return head.load(std::memory_order_acquire); }
+    uint16_t capacity() const { return mask + 1; }
+
+  protected:
+    struct Slot
+    {
+      std::atomic<uint32_t> seq;    //2 * position + 1 while written, + 2 when done
+      std::atomic<uint32_t> word;   //raw, channel, gain code and flags
+      std::atomic<uint32_t> timestamp;
+    };
+
+    AD7794_Broadcast(Slot *storage, uint16_t size);
+
+  private:
+    friend class AD7794_BroadcastReader;
+
+    Slot *slots;
+    uint16_t mask;
+    std::atomic<uint32_t> head;
+};
+
+// N must be a power of 2, 2 or more
+template <uint16_t N>
+class AD7794_BroadcastRing : public AD7794_Broadcast
+{
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "AD7794_BroadcastRing size must be a power of 2");
+
+  public:
+    AD7794_BroadcastRing() : AD7794_Broadcast(storage, N) {}
+
+  private:
+    Slot storage[N];
+};
+
+/* One per consumer task. Starts at the newest sample. */
+class AD7794_BroadcastReader
+{
+  public:
+    AD7794_BroadcastReader(AD7794_Broadcast &ring);
+
+    bool read(AD7794_Sample &sample);   //Never blocks, false when there is nothing new
+    uint16_t available() const;
+    uint32_t lost() const { return lostCount; }
+
+  private:
+    AD7794_Broadcast &ring;
+    uint32_t pos;
+    uint32_t lostCount;
+};
+
+typedef void (*AD7794_Command)(AD7794 &adc, void *arg);
+
+#define AD7794_ACQ_MAX_PAUSE_US   10000   //Longest sleep of the acquisition task between polls
+#define AD7794_ACQ_POLL_GAP_US       20   //Between polls once a result is due
+
+/* Acquisition task. Owns one AD7794 and scans its enabled channels,
+   publishing every result to a broadcast ring. No other task may call the
+   AD7794 directly while it runs: settings are changed with call(), which
+   runs a function on the acquisition task between two results (the scan
+   is stopped around it) and waits for it to finish.
+
+   run() is the task body. On ESP32 start() creates a FreeRTOS task for it.
+   On other systems run it from a thread of your own (e.g. std::thread),
+   calling markRunning() before the thread is created.
+   Between results the task sleeps for as long as the chip can't have one
+   (AD7794::getScanWait(), at most AD7794_ACQ_MAX_PAUSE_US so call() is
+   served): vTaskDelay() for whole ticks, delayMicroseconds() for the rest.
+*/
+class AD7794_Acquisition
+{
+  public:
+    AD7794_Acquisition(AD7794 &adc, AD7794_Broadcast &out);
+
+    //Acquisition task side
+    bool step();                        //One poll, true if a sample was published
+    void run();                         //step() until stop()
+
+    //Any other task
+    bool call(AD7794_Command fn, void *arg);  //false if the task stopped first
+    bool markRunning();                 //Before starting run() on a thread of your own
+    void stop();
+    bool isRunning() const { return running.load(); }
+
+#if defined(ESP32)
+    bool start(uint32_t stackBytes = 4096, UBaseType_t priority = 5, BaseType_t core = tskNO_AFFINITY);
+#endif
+
+  private:
+    enum { CallFree = 0, CallClaimed, CallPosted, CallDone };
+
+    void pause(uint32_t us);
+    static void waitTurn();
+#if defined(ESP32)
+    static void taskEntry(void *arg);
+#endif
+
+    AD7794 &adc;
+    AD7794_Broadcast &out;
+    std::atomic<bool> running;
+    std::atomic<bool> stopRequested;
+
+    std::atomic<uint8_t> callState;
+    AD7794_Command callFn;
+    void *callArg;
+};
+
+#endif //AD7794_RTOS_AVAILABLE
+
+#endif
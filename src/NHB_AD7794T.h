@@ -0,0 +1,264 @@
+/*
+  NHB_AD7794T.h - Compile-time configured AD7794 driver
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef NHB_AD7794T_h
+#define NHB_AD7794T_h
+
+#include "NHB_AD7794.h"
+
+/* For rigs whose configuration is fixed at compile time. The channel
+   settings, update rate and chop setting are template parameters, so the
+   conf and mode register words, settling times and scale factors are all
+   constants, the scan over the channels is unrolled, and the object holds
+   no data at all. Register access goes through AD7794Bus, same as AD7794,
+   on the default SPI port unless AD7794_Setup names another (AD7794_Port).
+
+     typedef AD7794T<10, AD7794_Setup<AD7794_rateCode(470)>,
+                     AD7794_Ch<0, 128>,
+                     AD7794_Ch<1, 128>,
+                     AD7794_Ch<6> > Adc;           //Temperature, internal 1.17 V reference
+
+     Adc::begin();
+     uint32_t raw = Adc::readRaw<0>();          //First channel in the list
+     int32_t uv = Adc::toFixed<0>(raw);         //Fixed point microvolts
+*/
+
+constexpr uint8_t AD7794_gainBits(uint8_t gain)
+{
+  return gain <= 1 ? 0 : 1 + AD7794_gainBits(gain >> 1);
+}
+
+
+/* Bus for AD7794T: a global SPIClass (SPI, SPI1 ...) or any global
+   AD7794_Transport, e.g. an AD7794_LockedTransport shared with other tasks.
+
+     AD7794_Setup<AD7794_rateCode(470), true, 4000000, AD7794_Port<SPIClass, SPI1> >
+     AD7794_Setup<AD7794_rateCode(470), true, 4000000, AD7794_Port<AD7794_LockedTransport, port> >
+*/
+template <typename T, T &Bus>
+struct AD7794_Port
+{
+  static T &get() { return Bus; }
+};
+
+
+/* Chip wide settings: update rate code (see AD7794_rateCode()), chop,
+   SPI clock and bus
+*/
+template <uint8_t FsCode = 0x01, bool Chop = true, uint32_t SpiHz = 4000000,
+          typename Port = AD7794_Port<SPIClass, SPI> >
+struct AD7794_Setup
+{
+  static_assert(FsCode >= 1 && FsCode <= 15, "AD7794_Setup: FS code must be 1..15");
+
+  static constexpr uint16_t modeSingle = ((uint16_t)1 << 13) | (Chop ? 0 : AD7794_CHOP_DISABLE) | FsCode;
+  static constexpr uint32_t periodUs = AD7794_Timing<>::periodUs[FsCode];
+  static constexpr uint32_t settleUs = Chop ? AD7794_Timing<>::settleUs[FsCode] : periodUs;
+  static constexpr uint32_t timeoutUs = settleUs + settleUs / 2 + 1000;
+  static constexpr uint32_t pollGapUs = periodUs / 32;
+  static constexpr uint32_t spiHz = SpiHz;
+  typedef Port port;
+};
+
+
+/* One channel: AIN number (0-5, 6 = temperature, 7 = AVDD monitor) and its
+   settings. VRefMv is only used for scaling. Channels 6 and 7 are measured
+   against the internal reference, as in AD7794::rawToVolts(), so they
+   default to it and take no other VRefMv.
+*/
+template <uint8_t Ch, uint8_t Gain = 1, bool Bipolar = true, bool Buffered = true,
+          uint8_t RefMode = (Ch >= 6 ? AD7794_REF_INT : AD7794_REF_EXT_1),
+          uint16_t VRefMv = (Ch >= 6 ? 1170 : 2500), bool VBias = false>
+struct AD7794_Ch
+{
+  static_assert(Ch < AD7794_CHANNEL_COUNT, "AD7794_Ch: channel must be 0..7");
+  static_assert(Ch < 6 || VRefMv == 1170,
+                "AD7794_Ch: channels 6 and 7 use the internal 1.17 V reference");
+  static_assert(Gain >= 1 && Gain <= 128 && (Gain & (Gain - 1)) == 0, "AD7794_Ch: gain must be 1, 2, 4 ... 128");
+
+  static constexpr uint8_t channel = Ch;
+
+  //Same layout as AD7794::buildConfReg()
+  static constexpr uint16_t confReg =
+      ((VBias && Ch < 3) ? (((uint16_t)(Ch + 1) << 14) | (1 << 11)) : 0) |
+      ((uint16_t)!Bipolar << 12) |
+      ((uint16_t)AD7794_gainBits(Gain) << 8) |
+      ((uint16_t)RefMode << 6) |
+      ((uint16_t)Buffered << 4) |
+      Ch;
+
+  //Scale factors, see AD7794_Scale
+  static constexpr int32_t zero = Bipolar ? AD7794_ADC_MAX_BP : 0;
+  static constexpr uint8_t shift = Bipolar ? 23 : 24;
+  static constexpr int32_t mult = (int32_t)(((int64_t)VRefMv * 1000 * (1L << AD7794_FIXED_FRAC_BITS) + Gain / 2) / Gain);
+};
+
+
+//Type of the Ith entry of a parameter pack
+template <uint8_t I, typename Head, typename... Tail>
+struct AD7794_TypeAt
+{
+  typedef typename AD7794_TypeAt<I - 1, Tail...>::type type;
+};
+
+template <typename Head, typename... Tail>
+struct AD7794_TypeAt<0, Head, Tail...>
+{
+  typedef Head type;
+};
+
+template <uint8_t I> struct AD7794_Index {};
+
+
+template <uint8_t CsPin, typename Setup, typename... Channels>
+class AD7794T
+{
+  public:
+    static constexpr uint8_t channelCount = sizeof...(Channels);
+
+    static void begin()
+    {
+      pinMode(CsPin, OUTPUT);
+      digitalWrite(CsPin, HIGH);
+      Bus::get().begin();
+
+      Bus::get().beginTransaction(settings());
+      digitalWrite(CsPin, LOW);
+      AD7794Bus::reset(Bus::get());
+      digitalWrite(CsPin, HIGH);
+      Bus::get().endTransaction();
+      delay(2); //4 times the recomended period
+
+      readRaw<0>(); //The very first value read is usually junk
+    }
+
+    //Single conversion on the Ith channel of the list. Returns the raw
+    //code, or AD7794_READ_ERROR if the chip didn't answer in time.
+    template <uint8_t I>
+    static uint32_t readRaw()
+    {
+      return convert<typename AD7794_TypeAt<I, Channels...>::type>();
+    }
+
+    template <uint8_t I>
+    static int32_t toFixed(uint32_t raw)
+    {
+      typedef typename AD7794_TypeAt<I, Channels...>::type C;
+      return (int32_t)(((int64_t)((int32_t)raw - C::zero) * C::mult) >> C::shift);
+    }
+
+    template <uint8_t I>
+    static float toVolts(uint32_t raw)
+    {
+      typedef typename AD7794_TypeAt<I, Channels...>::type C;
+      return ((int32_t)raw - C::zero) * ((float)C::mult / (1e6 * (1L << AD7794_FIXED_FRAC_BITS)) / (1L << C::shift));
+    }
+
+    //Every channel in list order. Returns how many were read without error.
+    static uint8_t readAllRaw(uint32_t *buf)
+    {
+      return readAll(buf, AD7794_Index<0>());
+    }
+
+    static uint8_t readAllFixed(int32_t *buf)
+    {
+      return readAllFixed(buf, AD7794_Index<0>());
+    }
+
+  private:
+    static_assert(sizeof...(Channels) > 0, "AD7794T needs at least one channel");
+
+    typedef typename Setup::port Bus;
+
+    static SPISettings settings()
+    {
+      return SPISettings(Setup::spiHz, MSBFIRST, SPI_MODE3);
+    }
+
+    //Conf and mode writes go out as one bulk transfer, then the bus is left
+    //alone until the settling time is up
+    template <typename C>
+    static uint32_t convert()
+    {
+      Bus::get().beginTransaction(settings());
+      digitalWrite(CsPin, LOW);
+      AD7794Bus::writeConfMode(Bus::get(), C::confReg, Setup::modeSingle);
+      digitalWrite(CsPin, HIGH);
+      Bus::get().endTransaction();
+
+      uint32_t start = micros();
+      while(micros() - start < Setup::settleUs){
+        yield();
+      }
+
+      for(;;){
+        Bus::get().beginTransaction(settings());
+        digitalWrite(CsPin, LOW);
+        bool ready = (AD7794Bus::readStatus(Bus::get()) & 0x80) == 0;
+        uint32_t raw = ready ? AD7794Bus::readData(Bus::get()) : AD7794_READ_ERROR;
+        digitalWrite(CsPin, HIGH);
+        Bus::get().endTransaction();
+
+        if(ready){
+          return raw;
+        }
+        if(micros() - start > Setup::timeoutUs){
+          return AD7794_READ_ERROR;
+        }
+        delayMicroseconds(Setup::pollGapUs);
+      }
+    }
+
+    //Unrolled at compile time, one call per channel
+    template <uint8_t I>
+    static uint8_t readAll(uint32_t *buf, AD7794_Index<I>)
+    {
+      buf[I] = readRaw<I>();
+      return (buf[I] != AD7794_READ_ERROR) + readAll(buf, AD7794_Index<I + 1>());
+    }
+
+    static uint8_t readAll(uint32_t *, AD7794_Index<sizeof...(Channels)>)
+    {
+      return 0;
+    }
+
+    template <uint8_t I>
+    static uint8_t readAllFixed(int32_t *buf, AD7794_Index<I>)
+    {
+      uint32_t raw = readRaw<I>();
+      buf[I] = (raw == AD7794_READ_ERROR) ? AD7794_FIXED_ERROR : toFixed<I>(raw);
+      return (raw != AD7794_READ_ERROR) + readAllFixed(buf, AD7794_Index<I + 1>());
+    }
+
+    static uint8_t readAllFixed(int32_t *, AD7794_Index<sizeof...(Channels)>)
+    {
+      return 0;
+    }
+};
+
+#endif
@@ -0,0 +1,299 @@
+/*
+  NHB_AD7794Thermocouple.cpp - Thermocouple conversion with cached cold
+  junction compensation
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "NHB_AD7794Thermocouple.h"
+
+/* One piece of a NIST ITS-90 polynomial, valid for lo <= x <= hi.
+   Coefficients are stored lowest order first, as published. */
+struct AD7794_TcInverse
+{
+  float lo, hi;     //mV
+  uint8_t n;
+  float c[10];
+};
+
+struct AD7794_TcDirect
+{
+  float lo, hi;     //deg C
+  uint8_t n;
+  float c[15];
+};
+
+// https://srdata.nist.gov/its90/type_k/kcoefficients_inverse.html
+static const AD7794_TcInverse kInverse[] PROGMEM = {
+  {-5.891, 0.0, 9, {0.0, 2.5173462E+01, -1.1662878E+00, -1.0833638E+00,
+                    -8.9773540E-01, -3.7342377E-01, -8.6632643E-02,
+                    -1.0450598E-02, -5.1920577E-04}},
+  {0.0, 20.644, 10, {0.0, 2.508355E+01, 7.860106E-02, -2.503131E-01,
+                     8.315270E-02, -1.228034E-02, 9.804036E-04,
+                     -4.413030E-05, 1.057734E-06, -1.052755E-08}},
+  {20.644, 54.886, 7, {-1.318058E+02, 4.830222E+01, -1.646031E+00,
+                       5.464731E-02, -9.650715E-04, 8.802193E-06,
+                       -3.110810E-08}}
+};
+
+// https://srdata.nist.gov/its90/type_j/jcoefficients_inverse.html
+static const AD7794_TcInverse jInverse[] PROGMEM = {
+  {-8.095, 0.0, 9, {0.0, 1.9528268E+01, -1.2286185E+00, -1.0752178E+00,
+                    -5.9086933E-01, -1.7256713E-01, -2.8131513E-02,
+                    -2.3963370E-03, -8.3823321E-05}},
+  {0.0, 42.919, 8, {0.0, 1.978425E+01, -2.001204E-01, 1.036969E-02,
+                    -2.549687E-04, 3.585153E-06, -5.344285E-08,
+                    5.099890E-10}},
+  {42.919, 69.553, 6, {-3.11358187E+03, 3.00543684E+02, -9.94773230E+00,
+                       1.70276630E-01, -1.43033468E-03, 4.73886084E-06}}
+};
+
+// https://srdata.nist.gov/its90/type_t/tcoefficients_inverse.html
+static const AD7794_TcInverse tInverse[] PROGMEM = {
+  {-5.603, 0.0, 8, {0.0, 2.5949192E+01, -2.1316967E-01, 7.9018692E-01,
+                    4.2527777E-01, 1.3304473E-01, 2.0241446E-02,
+                    1.2668171E-03}},
+  {0.0, 20.872, 7, {0.0, 2.592800E+01, -7.602961E-01, 4.637791E-02,
+                    -2.165394E-03, 6.048144E-05, -7.293422E-07}}
+};
+
+// https://srdata.nist.gov/its90/type_k/kcoefficients.html
+// (the 0..1372 C piece also has an exponential term, added in code)
+static const AD7794_TcDirect kDirect[] PROGMEM = {
+  {-270.0, 0.0, 11, {0.0, 0.394501280250E-01, 0.236223735980E-04,
+                     -0.328589067840E-06, -0.499048287770E-08,
+                     -0.675090591730E-10, -0.574103274280E-12,
+                     -0.310888728940E-14, -0.104516093650E-16,
+                     -0.198892668780E-19, -0.163226974860E-22}},
+  {0.0, 1372.0, 10, {-0.176004136860E-01, 0.389212049750E-01,
+                     0.185587700320E-04, -0.994575928740E-07,
+                     0.318409457190E-09, -0.560728448890E-12,
+                     0.560750590590E-15, -0.320207200030E-18,
+                     0.971511471520E-22, -0.121047212750E-25}}
+};
+
+// https://srdata.nist.gov/its90/type_j/jcoefficients.html
+static const AD7794_TcDirect jDirect[] PROGMEM = {
+  {-210.0, 760.0, 9, {0.0, 0.503811878150E-01, 0.304758369300E-04,
+                      -0.856810657200E-07, 0.132281952950E-09,
+                      -0.170529583370E-12, 0.209480906970E-15,
+                      -0.125383953360E-18, 0.156317256970E-22}},
+  {760.0, 1200.0, 6, {0.296456256810E+03, -0.149761277860E+01,
+                      0.317871039240E-02, -0.318476867010E-05,
+                      0.157208190040E-08, -0.306913690560E-12}}
+};
+
+// https://srdata.nist.gov/its90/type_t/tcoefficients.html
+static const AD7794_TcDirect tDirect[] PROGMEM = {
+  {-270.0, 0.0, 15, {0.0, 0.387481063640E-01, 0.441944343470E-04,
+                     0.118443231050E-06, 0.200329735540E-07,
+                     0.901380195590E-09, 0.226511565930E-10,
+                     0.360711542050E-12, 0.384939398830E-14,
+                     0.282135219250E-16, 0.142515947790E-18,
+                     0.487686622860E-21, 0.107955392700E-23,
+                     0.139450270620E-26, 0.797951539270E-30}},
+  {0.0, 400.0, 9, {0.0, 0.387481063640E-01, 0.332922278800E-04,
+                   0.206182434040E-06, -0.218822568460E-08,
+                   0.109968809280E-10, -0.308157587720E-13,
+                   0.454791352900E-16, -0.275129016730E-19}}
+};
+
+/* horner - Evaluates c[0] + c[1]*x + ... + c[n-1]*x^(n-1) from PROGMEM */
+static float horner(const float *c, uint8_t n, float x)
+{
+  float y = pgm_read_float(&c[n - 1]);
+
+  for(uint8_t i = n - 1; i > 0; i--){
+    y = y * x + pgm_read_float(&c[i - 1]);
+  }
+
+  return y;
+}
+
+float AD7794_tcMvToDegC(AD7794_TcType type, float mV)
+{
+  const AD7794_TcInverse *table;
+  uint8_t pieces;
+
+  switch(type){
+    case AD7794_TC_J:
+      table = jInverse;
+      pieces = sizeof(jInverse) / sizeof(jInverse[0]);
+      break;
+    case AD7794_TC_T:
+      table = tInverse;
+      pieces = sizeof(tInverse) / sizeof(tInverse[0]);
+      break;
+    default:
+      table = kInverse;
+      pieces = sizeof(kInverse) / sizeof(kInverse[0]);
+      break;
+  }
+
+  for(uint8_t i = 0; i < pieces; i++){
+    if(mV <= pgm_read_float(&table[i].hi)){
+      if(mV < pgm_read_float(&table[i].lo)){
+        break;
+      }
+      return horner(table[i].c, pgm_read_byte(&table[i].n), mV);
+    }
+  }
+
+  return NAN;
+}
+
+float AD7794_tcDegCToMv(AD7794_TcType type, float degC)
+{
+  const AD7794_TcDirect *table;
+  uint8_t pieces;
+
+  switch(type){
+    case AD7794_TC_J:
+      table = jDirect;
+      pieces = sizeof(jDirect) / sizeof(jDirect[0]);
+      break;
+    case AD7794_TC_T:
+      table = tDirect;
+      pieces = sizeof(tDirect) / sizeof(tDirect[0]);
+      break;
+    default:
+      table = kDirect;
+      pieces = sizeof(kDirect) / sizeof(kDirect[0]);
+      break;
+  }
+
+  for(uint8_t i = 0; i < pieces; i++){
+    if(degC <= pgm_read_float(&table[i].hi)){
+      if(degC < pgm_read_float(&table[i].lo)){
+        break;
+      }
+
+      float mV = horner(table[i].c, pgm_read_byte(&table[i].n), degC);
+
+      if(type == AD7794_TC_K && degC > 0.0){
+        float d = degC - 126.9686;
+        mV += 0.1185976 * exp(-0.0001183432 * d * d);
+      }
+      return mV;
+    }
+  }
+
+  return NAN;
+}
+
+
+AD7794_Thermocouple::AD7794_Thermocouple(AD7794 &adc) : adc(adc)
+{
+  cjcDegC = NAN;
+  cjcOffset = 0.0;
+  interval = AD7794_TC_DEFAULT_INTERVAL;
+  sinceCjc = 0;
+  cjcValid = false;
+
+  for(uint8_t i = 0; i < 3; i++){
+    cjcMv[i] = NAN;
+  }
+}
+
+/* setCjcInterval - Number of thermocouple samples between cold junction
+   reads. The junction moves slowly, a few seconds between reads is plenty.
+   With 0 the junction is only read by refreshCjc() (and the first read()). */
+void AD7794_Thermocouple::setCjcInterval(uint16_t samples)
+{
+  interval = samples;
+}
+
+/* setCjcOffset - Applies to the cached junction temperature at once, so it
+   holds with setCjcInterval(0) too. */
+void AD7794_Thermocouple::setCjcOffset(float degC)
+{
+  if(cjcValid){
+    cjcDegC += degC - cjcOffset;
+  }
+  cjcOffset = degC;
+  for(uint8_t i = 0; i < 3; i++){
+    cjcMv[i] = NAN;
+  }
+}
+
+/* refreshCjc - Reads the chip temperature on channel 6 and drops the cached
+   junction voltages. Returns false (keeping the old value) if the read
+   failed. */
+bool AD7794_Thermocouple::refreshCjc()
+{
+  float degC = adc.read(AD7794_TC_CJC_CHANNEL);
+
+  sinceCjc = 0;
+  if(isnan(degC)){
+    return false;
+  }
+
+  cjcDegC = degC + cjcOffset;
+  cjcValid = true;
+  for(uint8_t i = 0; i < 3; i++){
+    cjcMv[i] = NAN;
+  }
+  return true;
+}
+
+float AD7794_Thermocouple::getCjcTemp()
+{
+  return cjcDegC;
+}
+
+/* read - Reads thermocouple channel ch and returns the compensated
+   temperature. The channel should be set up bipolar with enough gain for
+   the expected range (e.g. 32 or 64 for K type). */
+float AD7794_Thermocouple::read(uint8_t ch, AD7794_TcType type)
+{
+  if(!cjcValid || (interval != 0 && sinceCjc >= interval)){
+    refreshCjc();
+  }
+  sinceCjc++;
+
+  float volts = adc.read(ch);
+
+  if(isnan(volts)){
+    return NAN;
+  }
+  return toDegC(volts, type);
+}
+
+/* toDegC - Compensates a thermocouple voltage already read (e.g. through
+   the non-blocking interface) with the cached junction temperature. */
+float AD7794_Thermocouple::toDegC(float tcVolts, AD7794_TcType type)
+{
+  if(!cjcValid){
+    return NAN;
+  }
+
+  uint8_t t = (uint8_t)type < 3 ? (uint8_t)type : 0;
+
+  if(isnan(cjcMv[t])){
+    cjcMv[t] = AD7794_tcDegCToMv(type, cjcDegC);
+  }
+
+  return AD7794_tcMvToDegC(type, tcVolts * 1000.0 + cjcMv[t]);
+}
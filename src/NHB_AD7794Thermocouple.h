@@ -0,0 +1,84 @@
+/*
+  NHB_AD7794Thermocouple.h - Thermocouple conversion with cached cold
+  junction compensation
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef NHB_AD7794_THERMOCOUPLE_h
+#define NHB_AD7794_THERMOCOUPLE_h
+
+#include "NHB_AD7794.h"
+
+#define AD7794_TC_CJC_CHANNEL       6
+#define AD7794_TC_DEFAULT_INTERVAL  16
+
+enum AD7794_TcType
+{
+  AD7794_TC_K,
+  AD7794_TC_J,
+  AD7794_TC_T
+};
+
+/* Thermocouple voltage (mV) <-> temperature (deg C) using the NIST ITS-90
+   reference polynomials, piecewise over the NIST ranges and evaluated in
+   Horner form from PROGMEM tables. NIST gives the inverse fits as within
+   +/-0.06 deg C (K), +/-0.05 (J) and +/-0.04 (T) of the reference tables;
+   a temperature -> mV -> temperature round trip stays within 0.07 deg C
+   over the whole range. Out of range inputs return NAN.
+*/
+float AD7794_tcMvToDegC(AD7794_TcType type, float mV);
+float AD7794_tcDegCToMv(AD7794_TcType type, float degC);
+
+/* Reads thermocouples on one AD7794 with cold junction compensation from
+   the on-chip temperature sensor (channel 6). The junction temperature is
+   read once every setCjcInterval() thermocouple samples and the matching
+   thermocouple voltage is cached per type, so a thermocouple reading costs
+   one conversion plus one polynomial instead of two conversions.
+*/
+class AD7794_Thermocouple
+{
+  public:
+    AD7794_Thermocouple(AD7794 &adc);
+
+    void setCjcInterval(uint16_t samples);  //0 = only on refreshCjc()
+    void setCjcOffset(float degC);          //Correction added to the chip sensor
+    bool refreshCjc();                      //Read channel 6 now
+    float getCjcTemp();
+
+    float read(uint8_t ch, AD7794_TcType type);      //Deg C, NAN on error
+    float toDegC(float tcVolts, AD7794_TcType type); //Using the cached CJC
+
+  private:
+    AD7794 &adc;
+    float cjcDegC;
+    float cjcOffset;
+    float cjcMv[3];         //Junction voltage per type, NAN until needed
+    uint16_t interval;
+    uint16_t sinceCjc;      //Thermocouple samples since the last CJC read
+    bool cjcValid;
+};
+
+#endif
@@ -0,0 +1,58 @@
+/*
+  NHB_AD7794Transport.cpp - SPI transport used by the AD7794 driver
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "NHB_AD7794Transport.h"
+
+AD7794_SPITransport::AD7794_SPITransport(SPIClass &spi) : spi(spi)
+{
+}
+
+void AD7794_SPITransport::begin()
+{
+  spi.begin();
+}
+
+void AD7794_SPITransport::beginTransaction(const SPISettings &settings)
+{
+  spi.beginTransaction(settings);
+}
+
+void AD7794_SPITransport::endTransaction()
+{
+  spi.endTransaction();
+}
+
+uint8_t AD7794_SPITransport::transfer(uint8_t data)
+{
+  return spi.transfer(data);
+}
+
+void AD7794_SPITransport::transfer(uint8_t *buf, uint16_t len)
+{
+  spi.transfer(buf, len);
+}
@@ -0,0 +1,71 @@
+/*
+  NHB_AD7794Transport.h - SPI transport used by the AD7794 driver
+
+  This file is part of the NHB_AD7794 library.
+
+  MIT License
+
+  Copyright (C) 2010,2019  Jaimy Juliano, NHBSystems
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef NHB_AD7794_TRANSPORT_h
+#define NHB_AD7794_TRANSPORT_h
+
+#include <Arduino.h>
+#include <SPI.h>
+
+/* The bus the driver talks through. Chip select stays with the driver
+   (DOUT/RDY only shows while CS is low), the transport only moves bytes.
+   Register accesses go out as one bulk transfer() each, so a transport
+   with a FIFO or DMA can send them back to back.
+*/
+class AD7794_Transport
+{
+  public:
+    virtual ~AD7794_Transport() {}
+
+    virtual void begin() = 0;
+    virtual void beginTransaction(const SPISettings &settings) = 0;
+    virtual void endTransaction() = 0;
+    virtual uint8_t transfer(uint8_t data) = 0;
+    virtual void transfer(uint8_t *buf, uint16_t len) = 0;   //Full duplex, in place
+};
+
+/* Transport on an Arduino SPIClass, SPI by default. Pass another instance
+   (SPI1, a second hardware port...) to keep the ADC off a bus that is
+   shared with something else, like an SD card.
+*/
+class AD7794_SPITransport : public AD7794_Transport
+{
+  public:
+    AD7794_SPITransport(SPIClass &spi = SPI);
+
+    void begin();
+    void beginTransaction(const SPISettings &settings);
+    void endTransaction();
+    uint8_t transfer(uint8_t data);
+    void transfer(uint8_t *buf, uint16_t len);
+
+  private:
+    SPIClass &spi;
+};
+
+#endif